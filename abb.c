@@ -1,29 +1,91 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
 
 #ifdef DEBUG
 #include <stdio.h>
 #endif
-#include "pila.h"
-#include <stdio.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "abb.h"
+#include "filtro.h"
 
-typedef int (*abb_comparar_clave_t) (const char *, const char *);
-typedef void (*abb_destruir_dato_t) (void *);
+struct abb_bloque;
 
+/* Cada nodo conoce a su padre, de forma que el sucesor y el predecesor
+in-order se calculan desde el propio nodo, sin pila ni recursion.
+Los nodos creados de a muchos comparten un bloque de memoria (ver
+abb_bloque); los creados de a uno tienen bloque NULL. */
 typedef struct abb_nodo {
     char* clave;
     void* dato;
     struct abb_nodo* izq;
     struct abb_nodo* der;
+    struct abb_nodo* padre;
+    struct abb_bloque* bloque;
 } abb_nodo_t;
 
-typedef struct abb {
+/* Nodo de un abb acotado: el nodo comun seguido de su lugar en la lista de
+uso y su vencimiento. Solo los abbs acotados piden nodos de este tamaño, y
+el resto del codigo los maneja como abb_nodo_t. */
+typedef struct abb_nodo_acotado {
+    abb_nodo_t nodo;
+    struct abb_nodo_acotado* lru_ant;
+    struct abb_nodo_acotado* lru_sig;
+    time_t vencimiento;         // 0 si la clave no vence
+} abb_nodo_acotado_t;
+
+/* Un unico malloc con varios nodos y sus claves a continuacion. Se libera
+cuando se libera el ultimo de sus nodos vivos, asi que solo los abbs sin
+acotar arman bloques: en uno acotado desalojar nodos no devolveria su
+memoria mientras quede vivo otro nodo del bloque. */
+typedef struct abb_bloque {
+    size_t vivos;
+    abb_nodo_t nodos[];
+} abb_bloque_t;
+
+struct abb {
     abb_comparar_clave_t comparar;
     abb_destruir_dato_t destruir;
     abb_nodo_t* raiz;
     size_t tam;
-} abb_t;
+    filtro_t* filtro;           // NULL si no se activo el filtro
+    double tasa_falsos_positivos;
+    abb_nodo_t** cache;         // nodos encontrados hace poco, por hash de clave
+    unsigned char* aciertos;    // aciertos recientes de cada entrada de la cache
+    size_t mascara_cache;
+    size_t memoria;             // bytes de nodos y claves
+    struct abb_lru* lru;        // NULL si el abb no esta acotado
+    size_t version;             // cambia al liberar nodos o sacarlos del abb
+    char* compactado_hasta;     // ultima clave movida por abb_compactar
+};
+
+/* Lista doblemente enlazada de los nodos de un abb acotado, del usado mas
+recientemente al menos reciente, con los limites a respetar. Vive fuera del
+struct abb para poder reordenarla desde las consultas, que reciben el abb
+como const */
+typedef struct abb_lru {
+    abb_nodo_acotado_t* primero;
+    abb_nodo_acotado_t* ultimo;
+    size_t max_elementos;
+    size_t max_memoria;
+} abb_lru_t;
+
+void abb_nodo_liberar(abb_t *arbol, abb_nodo_t* nodo);
+void abb_nodo_destruir(abb_t *arbol, abb_nodo_t* nodo);
+void abb_filtro_ajustar(abb_t *arbol);
+void abb_filtro_agregar_subarbol(abb_t *arbol, abb_nodo_t* raiz);
+void abb_filtro_desactivar(abb_t *arbol);
+void abb_cache_quitar(abb_t *arbol, abb_nodo_t* nodo);
+void abb_cache_vaciar(abb_t *arbol);
+void abb_cache_desactivar(abb_t *arbol);
+void abb_lru_usar(abb_lru_t* lru, abb_nodo_t* nodo);
+void abb_lru_quitar(abb_lru_t* lru, abb_nodo_t* nodo);
+void abb_acotar(abb_t *arbol, const abb_nodo_t* proteger);
 
 abb_t* abb_crear(abb_comparar_clave_t cmp, abb_destruir_dato_t destruir_dato) {
     abb_t* arbol = malloc(sizeof(abb_t));
@@ -33,244 +95,1976 @@ abb_t* abb_crear(abb_comparar_clave_t cmp, abb_destruir_dato_t destruir_dato) {
     arbol->destruir = destruir_dato;
     arbol->raiz = NULL;
     arbol->tam = 0;
+    arbol->filtro = NULL;
+    arbol->tasa_falsos_positivos = 0;
+    arbol->cache = NULL;
+    arbol->aciertos = NULL;
+    arbol->mascara_cache = 0;
+    arbol->memoria = 0;
+    arbol->lru = NULL;
+    arbol->version = 0;
+    arbol->compactado_hasta = NULL;
+
+    return arbol;
+}
+
+abb_t* abb_crear_acotado(abb_comparar_clave_t cmp, abb_destruir_dato_t destruir_dato, size_t max_elementos, size_t max_memoria) {
+    abb_t* arbol = abb_crear(cmp, destruir_dato);
+    if(!arbol) return NULL;
+
+    arbol->lru = malloc(sizeof(abb_lru_t));
+    if(!arbol->lru)
+    {
+        free(arbol);
+        return NULL;
+    }
+    arbol->lru->primero = NULL;
+    arbol->lru->ultimo = NULL;
+    arbol->lru->max_elementos = max_elementos;
+    arbol->lru->max_memoria = max_memoria;
 
     return arbol;
 }
 
+/* Hash de la clave de a 8 bytes por vez, con una mezcla final para
+repartir los bits. Se calcula en cada consulta con filtro o cache, asi que
+importa mas que sea barato que su calidad criptografica */
+uint64_t abb_hash_clave(const char *clave) {
+    size_t largo = strlen(clave);
+    uint64_t hash = largo * 0x9e3779b97f4a7c15ULL;
+    uint64_t palabra;
+    for(; largo >= sizeof(palabra); largo -= sizeof(palabra), clave += sizeof(palabra))
+    {
+        memcpy(&palabra, clave, sizeof(palabra));
+        hash = (hash ^ palabra) * 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 32;
+    }
+    palabra = 0;
+    memcpy(&palabra, clave, largo);
+    hash = (hash ^ palabra) * 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/* Avisa al filtro, si hay, que la clave entro al arbol o salio de el */
+void abb_filtro_agregar(abb_t *arbol, const char *clave) {
+    if(arbol->filtro)
+        filtro_agregar(arbol->filtro, abb_hash_clave(clave));
+}
+
+void abb_filtro_quitar(abb_t *arbol, const char *clave) {
+    if(arbol->filtro)
+        filtro_quitar(arbol->filtro, abb_hash_clave(clave));
+}
+
+/* Devuelve false solo si el filtro asegura que la clave no esta */
+bool abb_filtro_puede_estar(const abb_t *arbol, const char *clave) {
+    return !arbol->filtro || filtro_puede_estar(arbol->filtro, abb_hash_clave(clave));
+}
+
 /* Copia la clave en memoria */
 char* copiar_clave2(const char *clave) {
     char* clave_copiada = malloc(sizeof(char) * strlen(clave)+1);
+    if(!clave_copiada) return NULL;
     strcpy(clave_copiada, clave);
     return clave_copiada;
 }
 
-abb_nodo_t* abb_obtener_nodo(abb_comparar_clave_t cmp, const char *clave, abb_nodo_t* nodo, abb_nodo_t*** padre) {
-    if(!nodo)
-        return NULL;
-
-    int comp = cmp(clave, nodo->clave);
-
-    // A la derecha del nodo actual
-    if(comp > 0)
+/* Busca el nodo con la clave. Si no existe devuelve NULL y, si se pasan,
+deja en padre el ultimo nodo visitado y en enlace el puntero donde
+deberia colgarse un nodo nuevo con esa clave */
+abb_nodo_t* abb_obtener_nodo(abb_comparar_clave_t cmp, const char *clave, abb_nodo_t* nodo, abb_nodo_t** padre, abb_nodo_t*** enlace) {
+    while(nodo)
     {
+        int comp = cmp(clave, nodo->clave);
+        if(comp == 0)
+            return nodo;
+
         if(padre)
-            *padre = &nodo->der;
-        return abb_obtener_nodo(cmp, clave, nodo->der, padre);
+            *padre = nodo;
+        // A la derecha o a la izquierda del nodo actual
+        if(enlace)
+            *enlace = comp > 0 ? &nodo->der : &nodo->izq;
+        nodo = comp > 0 ? nodo->der : nodo->izq;
     }
-    else if(comp < 0)
+    return NULL;
+}
+
+/* Como abb_obtener_nodo, pero partiendo desde el nodo dedo en lugar de la
+raiz: sube hasta el primer ancestro cuyo subarbol puede contener la clave y
+baja desde ahi. Para claves cercanas a dedo recorre mucho menos que
+bajar desde la raiz */
+abb_nodo_t* abb_obtener_nodo_desde(const abb_t *arbol, abb_nodo_t* dedo, const char *clave, abb_nodo_t** padre, abb_nodo_t*** enlace) {
+    if(!dedo)
+        return abb_obtener_nodo(arbol->comparar, clave, arbol->raiz, padre, enlace);
+
+    int comp = arbol->comparar(clave, dedo->clave);
+    if(comp == 0)
+        return dedo;
+
+    // Solo acotan los ancestros de los que se llega subiendo del lado de la
+    // clave: desde la izquierda si es mayor a dedo, desde la derecha si es menor
+    abb_nodo_t* nodo = dedo;
+    while(nodo->padre)
     {
-        if(padre)
-            *padre = &nodo->izq;
-        return abb_obtener_nodo(cmp, clave, nodo->izq, padre);
+        bool desde_izq = nodo->padre->izq == nodo;
+        if(desde_izq == (comp > 0))
+        {
+            int comp_padre = arbol->comparar(clave, nodo->padre->clave);
+            if(comp_padre == 0)
+                return nodo->padre;
+            if((comp_padre < 0) == (comp > 0))
+                break;
+        }
+        nodo = nodo->padre;
     }
+    return abb_obtener_nodo(arbol->comparar, clave, nodo, padre, enlace);
+}
 
-    // A esta altura deberia tener el nodo que busco a la izquierda o la derecha y guardado en la variable nodo_buscado
+abb_nodo_t* abb_nodo_minimo(abb_nodo_t* nodo) {
+    while(nodo && nodo->izq)
+        nodo = nodo->izq;
     return nodo;
 }
 
-bool abb_guardar(abb_t *arbol, const char *clave, void *dato) {
-    if(!arbol || !clave) return false;
+abb_nodo_t* abb_nodo_maximo(abb_nodo_t* nodo) {
+    while(nodo && nodo->der)
+        nodo = nodo->der;
+    return nodo;
+}
+
+/* Sucesor in-order: el minimo del subarbol derecho o, si no hay, el primer
+ancestro del que se llega subiendo desde la izquierda */
+abb_nodo_t* abb_nodo_siguiente(abb_nodo_t* nodo) {
+    if(nodo->der)
+        return abb_nodo_minimo(nodo->der);
+    while(nodo->padre && nodo->padre->der == nodo)
+        nodo = nodo->padre;
+    return nodo->padre;
+}
+
+/* Predecesor in-order, simetrico a abb_nodo_siguiente */
+abb_nodo_t* abb_nodo_anterior(abb_nodo_t* nodo) {
+    if(nodo->izq)
+        return abb_nodo_maximo(nodo->izq);
+    while(nodo->padre && nodo->padre->izq == nodo)
+        nodo = nodo->padre;
+    return nodo->padre;
+}
+
+/* Bytes de cada nodo del arbol, sin la clave */
+size_t abb_nodo_tamanio(const abb_t *arbol) {
+    return arbol->lru ? sizeof(abb_nodo_acotado_t) : sizeof(abb_nodo_t);
+}
+
+/* Bytes que ocupan el nodo y su clave */
+size_t abb_nodo_memoria(const abb_t *arbol, const abb_nodo_t* nodo) {
+    return abb_nodo_tamanio(arbol) + strlen(nodo->clave) + 1;
+}
+
+/* Pre: el nodo es de un abb acotado */
+abb_nodo_acotado_t* abb_nodo_acotado(const abb_nodo_t* nodo) {
+    return (abb_nodo_acotado_t*) nodo;
+}
+
+/* Solo las claves de un abb acotado pueden vencer */
+bool abb_nodo_vencido_en(const abb_t *arbol, const abb_nodo_t* nodo, time_t ahora) {
+    if(!arbol->lru) return false;
+    time_t vencimiento = abb_nodo_acotado(nodo)->vencimiento;
+    return vencimiento && vencimiento <= ahora;
+}
+
+bool abb_nodo_vencido(const abb_t *arbol, const abb_nodo_t* nodo) {
+    return abb_nodo_vencido_en(arbol, nodo, time(NULL));
+}
+
+/* Devuelve el nodo de la menor clave mayor o igual a clave (estrictamente
+mayor si estricta), o el minimo si clave es NULL */
+abb_nodo_t* abb_nodo_cota_inferior(const abb_t *arbol, const char *clave, bool estricta) {
+    if(!clave) return abb_nodo_minimo(arbol->raiz);
+
+    abb_nodo_t* cota = NULL;
+    abb_nodo_t* nodo = arbol->raiz;
+    while(nodo)
+    {
+        int comp = arbol->comparar(clave, nodo->clave);
+        if(comp < 0 || (comp == 0 && !estricta))
+        {
+            cota = nodo;
+            nodo = nodo->izq;
+        }
+        else
+        {
+            nodo = nodo->der;
+        }
+    }
+    return cota;
+}
 
-    abb_nodo_t* nuevo_nodo = malloc(sizeof(abb_nodo_t));
-    if(!nuevo_nodo) return false;
+/* Guarda clave/dato buscando desde dedo (ver abb_obtener_nodo_desde) y
+devuelve el nodo de la clave, o NULL si no hubo memoria */
+abb_nodo_t* abb_guardar_desde(abb_t *arbol, abb_nodo_t* dedo, const char *clave, void *dato, time_t vencimiento) {
+    abb_nodo_t* padre = NULL;
+    abb_nodo_t** nodo_buscado_puntero = &arbol->raiz;
+    abb_nodo_t* nodo_buscado = abb_obtener_nodo_desde(arbol, dedo, clave, &padre, &nodo_buscado_puntero);
+
+    if(nodo_buscado)
+    {
+        if(arbol->destruir)
+            arbol->destruir(nodo_buscado->dato);
+        nodo_buscado->dato = dato;
+        if(arbol->lru)
+        {
+            abb_nodo_acotado(nodo_buscado)->vencimiento = vencimiento;
+            abb_lru_usar(arbol->lru, nodo_buscado);
+        }
+        return nodo_buscado;
+    }
+
+    abb_nodo_t* nuevo_nodo = malloc(abb_nodo_tamanio(arbol));
+    if(!nuevo_nodo) return NULL;
 
     nuevo_nodo->clave = copiar_clave2(clave);
+    if(!nuevo_nodo->clave)
+    {
+        free(nuevo_nodo);
+        return NULL;
+    }
     nuevo_nodo->dato = dato;
     nuevo_nodo->der = NULL;
     nuevo_nodo->izq = NULL;
+    nuevo_nodo->padre = padre;
+    nuevo_nodo->bloque = NULL;
 
-    abb_nodo_t** nodo_buscado_puntero = &arbol->raiz;
-    abb_nodo_t* nodo_buscado = abb_obtener_nodo(arbol->comparar, clave, arbol->raiz, &nodo_buscado_puntero);
+    *nodo_buscado_puntero = nuevo_nodo;
+    arbol->tam++;
+    arbol->memoria += abb_nodo_memoria(arbol, nuevo_nodo);
+    abb_filtro_agregar(arbol, clave);
+    abb_filtro_ajustar(arbol);
 
-    if(!nodo_buscado)
+    if(arbol->lru)
     {
-        *nodo_buscado_puntero = nuevo_nodo;
-        arbol->tam++;
+        abb_nodo_acotado_t* acotado = abb_nodo_acotado(nuevo_nodo);
+        acotado->lru_ant = NULL;
+        acotado->lru_sig = NULL;
+        acotado->vencimiento = vencimiento;
+        abb_lru_usar(arbol->lru, nuevo_nodo);
+        abb_acotar(arbol, nuevo_nodo);
     }
-    else
+
+    return nuevo_nodo;
+}
+
+bool abb_guardar_con_vencimiento(abb_t *arbol, const char *clave, void *dato, time_t vencimiento) {
+    if(!arbol || !clave || (vencimiento && !arbol->lru)) return false;
+    return abb_guardar_desde(arbol, NULL, clave, dato, vencimiento) != NULL;
+}
+
+bool abb_guardar(abb_t *arbol, const char *clave, void *dato) {
+    return abb_guardar_con_vencimiento(arbol, clave, dato, 0);
+}
+
+/* Busca el nodo de la clave pasando antes por el filtro y la cache, si
+estan activos. El hash de la clave se calcula una sola vez para ambos */
+abb_nodo_t* abb_buscar_nodo(const abb_t *arbol, const char *clave) {
+    if(!arbol->filtro && !arbol->cache)
+        return abb_obtener_nodo(arbol->comparar, clave, arbol->raiz, NULL, NULL);
+
+    uint64_t hash = abb_hash_clave(clave);
+    if(arbol->filtro && !filtro_puede_estar(arbol->filtro, hash))
+        return NULL;
+    if(!arbol->cache)
+        return abb_obtener_nodo(arbol->comparar, clave, arbol->raiz, NULL, NULL);
+
+    size_t posicion = hash & arbol->mascara_cache;
+    abb_nodo_t** entrada = &arbol->cache[posicion];
+    unsigned char* aciertos = &arbol->aciertos[posicion];
+    if(*entrada && arbol->comparar(clave, (*entrada)->clave) == 0)
     {
-        if(arbol->destruir)
-            arbol->destruir(nodo_buscado->dato);
-        nodo_buscado->dato = nuevo_nodo->dato;
-        free(nuevo_nodo->clave);
-        free(nuevo_nodo);
+        if(*aciertos < UCHAR_MAX)
+            (*aciertos)++;
+        return *entrada;
     }
 
-    return true;
+    // Una clave fria no desplaza enseguida a una frecuente: cada fallo
+    // descuenta un acierto y solo se reemplaza la entrada al llegar a cero
+    abb_nodo_t* nodo = abb_obtener_nodo(arbol->comparar, clave, arbol->raiz, NULL, NULL);
+    if(nodo && (!*entrada || *aciertos == 0))
+    {
+        *entrada = nodo;
+        *aciertos = 1;
+    }
+    else if(nodo)
+    {
+        (*aciertos)--;
+    }
+    return nodo;
+}
+
+/* Como abb_buscar_nodo, pero las claves vencidas se tratan como ausentes y
+en los abbs acotados la clave encontrada pasa a ser la usada mas reciente */
+abb_nodo_t* abb_buscar(const abb_t *arbol, const char *clave) {
+    abb_nodo_t* nodo = abb_buscar_nodo(arbol, clave);
+    if(!nodo || abb_nodo_vencido(arbol, nodo))
+        return NULL;
+    if(arbol->lru)
+        abb_lru_usar(arbol->lru, nodo);
+    return nodo;
 }
 
 void* abb_obtener(const abb_t *arbol, const char *clave) {
     if(!arbol || !clave) return NULL;
-    abb_nodo_t* nodo = abb_obtener_nodo(arbol->comparar, clave, arbol->raiz, NULL);
+    abb_nodo_t* nodo = abb_buscar(arbol, clave);
     return nodo ? nodo->dato : NULL;
 }
 
 bool abb_pertenece(const abb_t *arbol, const char *clave) {
     if(!arbol || !clave) return false;
 
-    return abb_obtener_nodo(arbol->comparar, clave, arbol->raiz, NULL) ? true : false;
+    return abb_buscar(arbol, clave) ? true : false;
 }
 
 size_t abb_cantidad(abb_t *arbol) {
     return arbol->tam;
 }
 
-void* abb_borrar(abb_t *arbol, const char *clave) {
-    if(!arbol || !clave || !arbol->raiz) return NULL;
+const char *abb_minimo(const abb_t *arbol) {
+    if(!arbol || !arbol->raiz) return NULL;
+    return abb_nodo_minimo(arbol->raiz)->clave;
+}
 
-    abb_nodo_t** nodo_buscado_puntero = &arbol->raiz;
-    abb_nodo_t* nodo_buscado = abb_obtener_nodo(arbol->comparar, clave, arbol->raiz, &nodo_buscado_puntero);
+const char *abb_maximo(const abb_t *arbol) {
+    if(!arbol || !arbol->raiz) return NULL;
+    return abb_nodo_maximo(arbol->raiz)->clave;
+}
 
-    if(!nodo_buscado) return NULL;
+/* Cuelga hijo en el lugar que ocupaba nodo dentro del arbol */
+void abb_trasplantar(abb_t *arbol, abb_nodo_t* nodo, abb_nodo_t* hijo) {
+    if(!nodo->padre)
+        arbol->raiz = hijo;
+    else if(nodo->padre->izq == nodo)
+        nodo->padre->izq = hijo;
+    else
+        nodo->padre->der = hijo;
 
-    void* dato_devolver = nodo_buscado->dato;
+    if(hijo)
+        hijo->padre = nodo->padre;
+}
 
-    // 2) Redireccion de punteros izq/der
-    // Caso 1: No tiene hijos
-    if(!nodo_buscado->der && !nodo_buscado->izq)
-    {
-        *nodo_buscado_puntero = NULL;
-    }
-    // Caso 2: Tiene un solo hijo
-    else if(!nodo_buscado->der && nodo_buscado->izq)
+/* Desengancha el nodo del arbol sin liberarlo. Los demas nodos no cambian
+de lugar en memoria, asi que los iteradores que apuntan a ellos siguen
+siendo validos */
+void abb_desenganchar(abb_t *arbol, abb_nodo_t* nodo) {
+    // Caso 1 y 2: No tiene hijos o tiene uno solo
+    if(!nodo->izq)
     {
-        *nodo_buscado_puntero = nodo_buscado->izq;
+        abb_trasplantar(arbol, nodo, nodo->der);
     }
-    else if(nodo_buscado->der && !nodo_buscado->izq)
+    else if(!nodo->der)
     {
-        *nodo_buscado_puntero = nodo_buscado->der;
+        abb_trasplantar(arbol, nodo, nodo->izq);
     }
-    // Caso 3: Buscar el mayor (mayor por izquierda)
-    else if(nodo_buscado->izq && nodo_buscado->der)
+    // Caso 3: Se sube el mayor por izquierda al lugar del nodo
+    else
     {
-
-        abb_nodo_t* temp = nodo_buscado->izq;
-        while(temp->der != NULL)
+        abb_nodo_t* mayor = abb_nodo_maximo(nodo->izq);
+        if(mayor != nodo->izq)
         {
-            #ifdef DEBUG
-            printf("Clave: %s\n", temp->clave);
-            #endif
-            temp = temp->der;
+            abb_trasplantar(arbol, mayor, mayor->izq);
+            mayor->izq = nodo->izq;
+            mayor->izq->padre = mayor;
         }
-        // Martin B. Theory.
-        char* clave_copiada = copiar_clave2(temp->clave);
-        void* dato = abb_borrar(arbol, clave_copiada);
-        free(nodo_buscado->clave);
-        nodo_buscado->clave = clave_copiada;
-        nodo_buscado->dato = dato;
-        return dato_devolver;
-        //*nodo_buscado_puntero = nodo_buscado->izq;
-        //temp->der = nodo_buscado->der;
+        abb_trasplantar(arbol, nodo, mayor);
+        mayor->der = nodo->der;
+        mayor->der->padre = mayor;
     }
     arbol->tam--;
-    free(nodo_buscado->clave);
-    free(nodo_buscado);
-    return dato_devolver;
 }
 
-void abb_destruir_recursivo(abb_nodo_t* nodo, abb_destruir_dato_t destruir_dato) {
-    if(!nodo) return;
+void* abb_borrar(abb_t *arbol, const char *clave) {
+    if(!arbol || !clave || !arbol->raiz) return NULL;
+
+    abb_nodo_t* nodo_buscado = abb_buscar_nodo(arbol, clave);
+
+    if(!nodo_buscado) return NULL;
+
+    // Una clave vencida ya no estaba: su dato se destruye en lugar de devolverse
+    if(abb_nodo_vencido(arbol, nodo_buscado))
+    {
+        abb_desenganchar(arbol, nodo_buscado);
+        abb_nodo_destruir(arbol, nodo_buscado);
+        return NULL;
+    }
+
+    void* dato_devolver = nodo_buscado->dato;
+    abb_desenganchar(arbol, nodo_buscado);
+    abb_nodo_liberar(arbol, nodo_buscado);
+    return dato_devolver;
+}
 
-    abb_destruir_recursivo(nodo->izq, destruir_dato);
-    abb_destruir_recursivo(nodo->der, destruir_dato);
-    if(destruir_dato)
-        destruir_dato(nodo->dato);
+/* Devuelve la memoria del nodo y su clave, sola o dentro de su bloque */
+void abb_nodo_liberar_memoria(abb_nodo_t* nodo) {
+    if(nodo->bloque)
+    {
+        if(--nodo->bloque->vivos == 0)
+            free(nodo->bloque);
+        return;
+    }
     free(nodo->clave);
     free(nodo);
 }
 
+/* Libera el nodo y su clave, sin tocar el dato */
+void abb_nodo_liberar(abb_t *arbol, abb_nodo_t* nodo) {
+    abb_filtro_quitar(arbol, nodo->clave);
+    abb_cache_quitar(arbol, nodo);
+    if(arbol->lru)
+        abb_lru_quitar(arbol->lru, nodo);
+    arbol->memoria -= abb_nodo_memoria(arbol, nodo);
+    arbol->version++;
+    abb_nodo_liberar_memoria(nodo);
+}
+
+/* Libera el nodo y su clave; el dato se destruye con la funcion del arbol */
+void abb_nodo_destruir(abb_t *arbol, abb_nodo_t* nodo) {
+    if(arbol->destruir)
+        arbol->destruir(nodo->dato);
+    abb_nodo_liberar(arbol, nodo);
+}
+
+/* Destruye los nodos del subarbol bajando siempre hacia una hoja y
+subiendo por el padre, sin recursion aunque el subarbol este degenerado.
+Devuelve cuantos destruyo.
+Pre: la raiz no tiene padre */
+size_t abb_destruir_subarbol(abb_t *arbol, abb_nodo_t* nodo) {
+    size_t cantidad = 0;
+    while(nodo)
+    {
+        if(nodo->izq)
+        {
+            nodo = nodo->izq;
+            continue;
+        }
+        if(nodo->der)
+        {
+            nodo = nodo->der;
+            continue;
+        }
+        abb_nodo_t* padre = nodo->padre;
+        if(padre && padre->izq == nodo)
+            padre->izq = NULL;
+        else if(padre)
+            padre->der = NULL;
+        abb_nodo_destruir(arbol, nodo);
+        cantidad++;
+        nodo = padre;
+    }
+    return cantidad;
+}
+
 void abb_destruir(abb_t *arbol) {
     if(!arbol) return;
-    abb_destruir_recursivo(arbol->raiz, arbol->destruir);
+    abb_filtro_desactivar(arbol);
+    abb_cache_desactivar(arbol);
+    abb_destruir_subarbol(arbol, arbol->raiz);
+    free(arbol->lru);
+    free(arbol->compactado_hasta);
     free(arbol);
 }
 
-/*
-La función destruir_dato se recibe en el constructor, para usarla en abb_destruir y en abb_insertar en el caso de que tenga que reemplazar el dato de una clave ya existente.
+size_t abb_memoria(const abb_t *arbol) {
+    return arbol ? arbol->memoria : 0;
+}
 
-Por otro lado deben implementar dos iteradores inorder.
-El iterador interno funciona usando la función de callback "visitar" que recibe la clave, el valor y un puntero extra, y devuelve true si se debe seguir iterando, false en caso contrario:
-*/
+/* ******************************************************************
+ *                  ABB ACOTADO: DESALOJO LRU Y VENCIMIENTO
+ * *****************************************************************/
 
-void abb_pos_order_recursivo(abb_nodo_t* nodo, bool visitar(const char *, void *, void *), void *extra) {
-    abb_pos_order_recursivo(nodo->izq, visitar, extra);
-    abb_pos_order_recursivo(nodo->der, visitar, extra);
-    if(!visitar(nodo->clave, nodo->dato, extra)) return;
-}
+/* Pasa el nodo al principio de la lista de uso */
+void abb_lru_usar(abb_lru_t* lru, abb_nodo_t* nodo_comun) {
+    abb_nodo_acotado_t* nodo = abb_nodo_acotado(nodo_comun);
+    if(lru->primero == nodo) return;
+    abb_lru_quitar(lru, nodo_comun);
 
-void abb_in_order_recursivo(abb_nodo_t* nodo, bool visitar(const char *, void *, void *), void *extra) {
-    if(!nodo) return;
-    abb_in_order_recursivo(nodo->izq, visitar, extra);
-    if(!visitar(nodo->clave, nodo->dato, extra)) return;
-    abb_in_order_recursivo(nodo->der, visitar, extra);
+    nodo->lru_ant = NULL;
+    nodo->lru_sig = lru->primero;
+    if(lru->primero)
+        lru->primero->lru_ant = nodo;
+    lru->primero = nodo;
+    if(!lru->ultimo)
+        lru->ultimo = nodo;
 }
 
-void abb_in_order(abb_t *arbol, bool visitar(const char *, void *, void *), void *extra) {
-    if(!arbol || !arbol->raiz) return;
-    abb_in_order_recursivo(arbol->raiz, visitar, extra);
+void abb_lru_quitar(abb_lru_t* lru, abb_nodo_t* nodo_comun) {
+    abb_nodo_acotado_t* nodo = abb_nodo_acotado(nodo_comun);
+    if(nodo->lru_ant)
+        nodo->lru_ant->lru_sig = nodo->lru_sig;
+    else if(lru->primero == nodo)
+        lru->primero = nodo->lru_sig;
+
+    if(nodo->lru_sig)
+        nodo->lru_sig->lru_ant = nodo->lru_ant;
+    else if(lru->ultimo == nodo)
+        lru->ultimo = nodo->lru_ant;
+
+    nodo->lru_ant = NULL;
+    nodo->lru_sig = NULL;
 }
 
-/* Y un iterador externo: */
+bool abb_excedido(const abb_t *arbol) {
+    return (arbol->lru->max_elementos && arbol->tam > arbol->lru->max_elementos)
+        || (arbol->lru->max_memoria && arbol->memoria > arbol->lru->max_memoria);
+}
 
-typedef struct abb_iter {
-    pila_t* pila;
-} abb_iter_t;
+/* Desaloja los nodos menos usados hasta volver dentro de los limites, sin
+tocar proteger (el recien guardado) */
+void abb_acotar(abb_t *arbol, const abb_nodo_t* proteger) {
+    while(abb_excedido(arbol) && arbol->lru->ultimo && &arbol->lru->ultimo->nodo != proteger)
+    {
+        abb_nodo_t* victima = &arbol->lru->ultimo->nodo;
+        abb_desenganchar(arbol, victima);
+        abb_nodo_destruir(arbol, victima);
+    }
+}
 
-void apilar_de_mayor_a_menor(pila_t* pila, abb_nodo_t* nodo) {
-    if(!nodo) return;
+/* Purga las claves vencidas a la hora dada */
+size_t abb_purgar_vencidos_en(abb_t *arbol, time_t ahora) {
+    size_t purgados = 0;
+    abb_nodo_t* nodo = abb_nodo_minimo(arbol->raiz);
+    while(nodo)
+    {
+        abb_nodo_t* siguiente = abb_nodo_siguiente(nodo);
+        if(abb_nodo_vencido_en(arbol, nodo, ahora))
+        {
+            abb_desenganchar(arbol, nodo);
+            abb_nodo_destruir(arbol, nodo);
+            purgados++;
+        }
+        nodo = siguiente;
+    }
+    return purgados;
+}
 
-    if(nodo->der != NULL)
-        apilar_de_mayor_a_menor(pila, nodo->der);
+size_t abb_purgar_vencidos(abb_t *arbol) {
+    if(!arbol) return 0;
+    return abb_purgar_vencidos_en(arbol, time(NULL));
+}
 
-    pila_apilar(pila, nodo);
+/* ******************************************************************
+ *                 FILTRO DE PERTENENCIA APROXIMADA
+ * *****************************************************************/
 
-    if(nodo->izq != NULL)
-        apilar_de_mayor_a_menor(pila, nodo->izq);
+void abb_filtro_agregar_subarbol(abb_t *arbol, abb_nodo_t* raiz) {
+    if(!arbol->filtro) return;
+    for(abb_nodo_t* nodo = abb_nodo_minimo(raiz); nodo; nodo = abb_nodo_siguiente(nodo))
+        abb_filtro_agregar(arbol, nodo->clave);
 }
 
-abb_iter_t *abb_iter_in_crear(const abb_t *arbol) {
-    if(!arbol) return NULL;
+/* Arma un filtro nuevo para la capacidad pedida con todas las claves del
+arbol. Si no hay memoria se conserva el filtro anterior */
+bool abb_filtro_reconstruir(abb_t *arbol, size_t capacidad) {
+    filtro_t* filtro = filtro_crear(capacidad, arbol->tasa_falsos_positivos);
+    if(!filtro) return false;
 
-    abb_iter_t* iter = malloc(sizeof(abb_iter_t));
-    if(!iter) return NULL;
-    iter->pila = NULL;
+    if(arbol->filtro)
+        filtro_destruir(arbol->filtro);
+    arbol->filtro = filtro;
+    abb_filtro_agregar_subarbol(arbol, arbol->raiz);
+    return true;
+}
+
+/* Si el arbol supero la capacidad del filtro, lo rearma con el doble para
+que la tasa de falsos positivos no crezca sin limite */
+void abb_filtro_ajustar(abb_t *arbol) {
+    if(arbol->filtro && arbol->tam > filtro_capacidad(arbol->filtro))
+        abb_filtro_reconstruir(arbol, 2 * arbol->tam);
+}
 
-    if(!arbol->raiz) return iter;
+bool abb_filtro_activar(abb_t *arbol, size_t capacidad, double tasa_falsos_positivos) {
+    if(!arbol || tasa_falsos_positivos <= 0 || tasa_falsos_positivos >= 1) return false;
 
-    pila_t* pila = pila_crear();
-    if(!pila)
+    double tasa_anterior = arbol->tasa_falsos_positivos;
+    arbol->tasa_falsos_positivos = tasa_falsos_positivos;
+    if(!abb_filtro_reconstruir(arbol, capacidad > arbol->tam ? capacidad : arbol->tam))
     {
-        free(iter);
-        return NULL;
+        arbol->tasa_falsos_positivos = tasa_anterior;
+        return false;
     }
-    apilar_de_mayor_a_menor(pila, arbol->raiz);
-    iter->pila = pila;
+    return true;
+}
 
-    return iter;
+void abb_filtro_desactivar(abb_t *arbol) {
+    if(!arbol || !arbol->filtro) return;
+    filtro_destruir(arbol->filtro);
+    arbol->filtro = NULL;
 }
 
-bool abb_iter_in_avanzar(abb_iter_t *iter) {
-    if(!iter || !iter->pila || pila_esta_vacia(iter->pila)) return false;
+bool abb_filtro_estadisticas(const abb_t *arbol, abb_filtro_estadisticas_t *estadisticas) {
+    if(!arbol || !arbol->filtro || !estadisticas) return false;
+
+    estadisticas->memoria = filtro_memoria(arbol->filtro);
+    estadisticas->capacidad = filtro_capacidad(arbol->filtro);
+    estadisticas->funciones_hash = filtro_funciones_hash(arbol->filtro);
+    estadisticas->tasa_falsos_positivos = filtro_tasa_estimada(arbol->filtro, arbol->tam);
+    return true;
+}
+
+/* ******************************************************************
+ *                    CACHE DE CLAVES FRECUENTES
+ * *****************************************************************/
+
+/* Tabla de acceso directo indexada por el hash de la clave que guarda un
+nodo encontrado hace poco en cada posicion, junto con sus aciertos. Con accesos muy sesgados las claves
+frecuentes se resuelven con un hash y una comparacion, sin bajar por el
+arbol. La cache nunca es la unica referencia a un nodo: se le quita al
+liberarlo y se vacia cuando los nodos se mueven a otro arbol. */
+
+void abb_cache_quitar(abb_t *arbol, abb_nodo_t* nodo) {
+    if(!arbol->cache) return;
+    abb_nodo_t** entrada = &arbol->cache[abb_hash_clave(nodo->clave) & arbol->mascara_cache];
+    if(*entrada == nodo)
+        *entrada = NULL;
+}
+
+void abb_cache_vaciar(abb_t *arbol) {
+    if(!arbol->cache) return;
+    for(size_t i = 0; i <= arbol->mascara_cache; i++)
+    {
+        arbol->cache[i] = NULL;
+        arbol->aciertos[i] = 0;
+    }
+}
 
-    pila_desapilar(iter->pila);
+bool abb_cache_activar(abb_t *arbol, size_t entradas) {
+    if(!arbol || !entradas) return false;
 
+    size_t largo = 1;
+    while(largo < entradas)
+        largo *= 2;
+
+    abb_nodo_t** cache = calloc(largo, sizeof(abb_nodo_t*));
+    unsigned char* aciertos = calloc(largo, sizeof(unsigned char));
+    if(!cache || !aciertos)
+    {
+        free(cache);
+        free(aciertos);
+        return false;
+    }
+
+    abb_cache_desactivar(arbol);
+    arbol->cache = cache;
+    arbol->aciertos = aciertos;
+    arbol->mascara_cache = largo - 1;
     return true;
 }
 
-const char *abb_iter_in_ver_actual(const abb_iter_t *iter) {
-    if(!iter || !iter->pila || pila_esta_vacia(iter->pila)) return NULL;
-    abb_nodo_t* nodo = pila_ver_tope(iter->pila);
-    return nodo->clave;
+void abb_cache_desactivar(abb_t *arbol) {
+    if(!arbol) return;
+    free(arbol->cache);
+    free(arbol->aciertos);
+    arbol->cache = NULL;
+    arbol->aciertos = NULL;
+    arbol->mascara_cache = 0;
 }
 
-bool abb_iter_in_al_final(const abb_iter_t *iter) {
-    if(!iter || !iter->pila) return true;
-    return pila_esta_vacia(iter->pila);
+/* ******************************************************************
+ *               OPERACIONES DE CONJUNTO SOBRE ARBOLES
+ * *****************************************************************/
+
+/* Todas mueven nodos entre arboles en lugar de copiar claves o pedir
+memoria para nodos nuevos. Partir y juntar recorren un solo camino desde la
+raiz. Unir, intersectar y diferencia eligen segun los tamaños: si uno de
+los arboles tiene muchas menos claves, cada una de ellas se busca en el
+otro desde la anterior, en O(m log(n/m + 1)) sobre un arbol balanceado; si
+no, recorren los dos arboles en orden a la par y rearman el resultado
+balanceado, en O(n + m). Ninguno recursa sobre la altura, que en un abb
+degenerado puede ser n. */
+
+/* Parte el subarbol de nodo en dos: las claves menores a clave quedan en
+menores y las mayores en mayores. El nodo con clave igual, si existe, se
+devuelve suelto. Recorre un solo camino desde la raiz */
+abb_nodo_t* abb_nodo_partir(abb_comparar_clave_t cmp, abb_nodo_t* nodo, const char *clave, abb_nodo_t** menores, abb_nodo_t** mayores) {
+    abb_nodo_t *padre_menores = NULL, *padre_mayores = NULL;
+    abb_nodo_t* igual = NULL;
+
+    while(nodo)
+    {
+        int comp = cmp(clave, nodo->clave);
+        if(comp > 0)
+        {
+            // El nodo y su subarbol izquierdo son menores
+            *menores = nodo;
+            nodo->padre = padre_menores;
+            padre_menores = nodo;
+            menores = &nodo->der;
+            nodo = nodo->der;
+        }
+        else if(comp < 0)
+        {
+            *mayores = nodo;
+            nodo->padre = padre_mayores;
+            padre_mayores = nodo;
+            mayores = &nodo->izq;
+            nodo = nodo->izq;
+        }
+        else
+        {
+            igual = nodo;
+            break;
+        }
+    }
+
+    *menores = igual ? igual->izq : NULL;
+    *mayores = igual ? igual->der : NULL;
+    if(*menores)
+        (*menores)->padre = padre_menores;
+    if(*mayores)
+        (*mayores)->padre = padre_mayores;
+
+    if(igual)
+    {
+        igual->izq = NULL;
+        igual->der = NULL;
+        igual->padre = NULL;
+    }
+    return igual;
 }
 
-void abb_iter_in_destruir(abb_iter_t* iter) {
-    if(!iter) return;
-    if(iter->pila)
-        pila_destruir(iter->pila, NULL);
-    free(iter);
+/* Como abb_nodo_partir, pero el nodo con clave igual va con los mayores,
+como su minimo. Devuelve el subarbol de claves mayores o iguales */
+abb_nodo_t* abb_nodo_cortar(abb_comparar_clave_t cmp, abb_nodo_t* nodo, const char *clave, abb_nodo_t** menores) {
+    abb_nodo_t* mayores;
+    abb_nodo_t* igual = abb_nodo_partir(cmp, nodo, clave, menores, &mayores);
+    if(!igual) return mayores;
+
+    abb_nodo_t* minimo = abb_nodo_minimo(mayores);
+    if(!minimo) return igual;
+    minimo->izq = igual;
+    igual->padre = minimo;
+    return mayores;
+}
+
+/* Junta menores, medio y mayores con medio como raiz.
+Pre: todas las claves de menores < medio < todas las de mayores */
+abb_nodo_t* abb_nodo_juntar3(abb_nodo_t* menores, abb_nodo_t* medio, abb_nodo_t* mayores) {
+    medio->izq = menores;
+    medio->der = mayores;
+    medio->padre = NULL;
+    if(menores)
+        menores->padre = medio;
+    if(mayores)
+        mayores->padre = medio;
+    return medio;
+}
+
+/* Junta dos subarboles subiendo el mayor de menores como raiz, de forma
+que la altura resultante es a lo sumo la mayor de las dos mas uno */
+abb_nodo_t* abb_nodo_juntar(abb_nodo_t* menores, abb_nodo_t* mayores) {
+    if(!menores) return mayores;
+    if(!mayores) return menores;
+
+    abb_nodo_t* mayor = abb_nodo_maximo(menores);
+    if(mayor == menores)
+    {
+        menores = mayor->izq;
+    }
+    else
+    {
+        mayor->padre->der = mayor->izq;
+        if(mayor->izq)
+            mayor->izq->padre = mayor->padre;
+    }
+    return abb_nodo_juntar3(menores, mayor, mayores);
+}
+
+/* Copia a nodos los nodos del subarbol, en orden */
+void abb_listar_nodos(abb_nodo_t* raiz, abb_nodo_t** nodos) {
+    for(abb_nodo_t* nodo = abb_nodo_minimo(raiz); nodo; nodo = abb_nodo_siguiente(nodo))
+        *nodos++ = nodo;
+}
+
+/* Como abb_nodo_armar, para un arreglo de punteros a nodos */
+abb_nodo_t* abb_nodo_armar_lista(abb_nodo_t** nodos, size_t inicio, size_t fin, abb_nodo_t* padre) {
+    if(inicio >= fin) return NULL;
+
+    size_t medio = inicio + (fin - inicio) / 2;
+    abb_nodo_t* nodo = nodos[medio];
+    nodo->padre = padre;
+    nodo->izq = abb_nodo_armar_lista(nodos, inicio, medio, nodo);
+    nodo->der = abb_nodo_armar_lista(nodos, medio + 1, fin, nodo);
+    return nodo;
+}
+
+/* Devuelve true si buscar cada una de pocas claves en un arbol de muchas,
+con unas log(muchas) comparaciones por clave, sale menos que recorrer
+los dos arboles a la par */
+bool abb_conviene_buscar(size_t pocas, size_t muchas) {
+    size_t altura = 1;
+    for(size_t resto = muchas; resto > 1; resto /= 2)
+        altura++;
+    return pocas * altura < muchas;
+}
+
+/* Pone nuevo en el lugar de viejo dentro del arbol */
+void abb_nodo_reemplazar(abb_t *arbol, abb_nodo_t* viejo, abb_nodo_t* nuevo) {
+    abb_trasplantar(arbol, viejo, nuevo);
+    nuevo->izq = viejo->izq;
+    nuevo->der = viejo->der;
+    if(nuevo->izq)
+        nuevo->izq->padre = nuevo;
+    if(nuevo->der)
+        nuevo->der->padre = nuevo;
+}
+
+/* Cuelga cada uno de los nodos sueltos de destino, en orden, buscando su
+lugar desde el anterior. Ante claves repetidas queda el nodo de otro, sea
+el de destino o el de la lista, y el de arbol se destruye. Devuelve cuantas
+claves estaban repetidas */
+size_t abb_enganchar_de_a_uno(abb_t *arbol, abb_t *destino, abb_nodo_t** nodos, size_t cantidad) {
+    size_t repetidos = 0;
+    abb_nodo_t* dedo = NULL;
+    for(size_t i = 0; i < cantidad; i++)
+    {
+        abb_nodo_t* nodo = nodos[i];
+        abb_nodo_t* padre = NULL;
+        abb_nodo_t** enlace = &destino->raiz;
+        abb_nodo_t* igual = abb_obtener_nodo_desde(destino, dedo, nodo->clave, &padre, &enlace);
+        if(!igual)
+        {
+            nodo->izq = NULL;
+            nodo->der = NULL;
+            nodo->padre = padre;
+            *enlace = nodo;
+            dedo = nodo;
+            continue;
+        }
+
+        repetidos++;
+        if(destino == arbol)
+        {
+            abb_nodo_reemplazar(arbol, igual, nodo);
+            abb_nodo_destruir(arbol, igual);
+            dedo = nodo;
+        }
+        else
+        {
+            abb_nodo_destruir(arbol, nodo);
+            dedo = igual;
+        }
+    }
+    return repetidos;
+}
+
+bool abb_unir(abb_t *arbol, abb_t *otro) {
+    if(!arbol || !otro || arbol->lru || otro->lru) return false;
+    if(arbol == otro || !otro->raiz) return true;
+
+    // Con un arbol mucho mas chico que el otro se cuelgan sus nodos en el
+    // grande, y el resultado queda con la forma del grande
+    bool pocos_en_otro = abb_conviene_buscar(otro->tam, arbol->tam);
+    if(pocos_en_otro || abb_conviene_buscar(arbol->tam, otro->tam))
+    {
+        abb_t* chico = pocos_en_otro ? otro : arbol;
+        abb_t* grande = pocos_en_otro ? arbol : otro;
+        abb_nodo_t** nodos = malloc(chico->tam * sizeof(abb_nodo_t*));
+        if(!nodos) return false;
+        abb_listar_nodos(chico->raiz, nodos);
+        size_t cantidad_chico = chico->tam;
+
+        abb_filtro_agregar_subarbol(arbol, otro->raiz);
+        if(otro->filtro)
+            filtro_vaciar(otro->filtro);
+        abb_cache_vaciar(otro);
+
+        size_t repetidos = abb_enganchar_de_a_uno(arbol, grande, nodos, cantidad_chico);
+        free(nodos);
+        arbol->raiz = grande->raiz;
+        arbol->tam += otro->tam - repetidos;
+        arbol->memoria += otro->memoria;
+        abb_filtro_ajustar(arbol);
+
+        otro->raiz = NULL;
+        otro->tam = 0;
+        otro->memoria = 0;
+        otro->version++;
+        return true;
+    }
+
+    // Los nodos de arbol van al final del arreglo del resultado: al mezclar
+    // la escritura nunca pasa a la lectura, porque va a lo sumo tantas
+    // posiciones atras como nodos de otro quedan por leer
+    size_t cantidad = arbol->tam, cantidad_otro = otro->tam;
+    abb_nodo_t** nodos = malloc((cantidad + 2 * cantidad_otro) * sizeof(abb_nodo_t*));
+    if(!nodos) return false;
+    abb_nodo_t** nodos_otro = nodos + cantidad + cantidad_otro;
+    abb_listar_nodos(arbol->raiz, nodos + cantidad_otro);
+    abb_listar_nodos(otro->raiz, nodos_otro);
+
+    // Las claves de otro entran al filtro de arbol; las repetidas salen al
+    // liberarse su nodo en arbol, asi que quedan contadas una sola vez
+    abb_filtro_agregar_subarbol(arbol, otro->raiz);
+    if(otro->filtro)
+        filtro_vaciar(otro->filtro);
+    abb_cache_vaciar(otro);
+
+    size_t i = cantidad_otro, j = 0, k = 0, repetidos = 0;
+    size_t fin = cantidad + cantidad_otro;
+    while(i < fin || j < cantidad_otro)
+    {
+        int comp = i == fin ? 1 : j == cantidad_otro ? -1 : arbol->comparar(nodos[i]->clave, nodos_otro[j]->clave);
+        if(comp < 0)
+        {
+            nodos[k++] = nodos[i++];
+            continue;
+        }
+        // Ante claves repetidas queda el nodo y el dato de otro
+        if(comp == 0)
+        {
+            abb_nodo_destruir(arbol, nodos[i++]);
+            repetidos++;
+        }
+        nodos[k++] = nodos_otro[j++];
+    }
+    arbol->raiz = abb_nodo_armar_lista(nodos, 0, k, NULL);
+    free(nodos);
+
+    arbol->tam += otro->tam - repetidos;
+    arbol->memoria += otro->memoria;
+    abb_filtro_ajustar(arbol);
+
+    otro->raiz = NULL;
+    otro->tam = 0;
+    otro->memoria = 0;
+    otro->version++;
+    return true;
+}
+
+/* Borra de arbol las claves de otro buscando cada una desde la anterior,
+como abb_borrar_lote */
+void abb_quitar_de_a_uno(abb_t *arbol, const abb_t *otro) {
+    abb_nodo_t* dedo = NULL;
+    for(abb_nodo_t* nodo_otro = abb_nodo_minimo(otro->raiz); nodo_otro && arbol->raiz; nodo_otro = abb_nodo_siguiente(nodo_otro))
+    {
+        abb_nodo_t* nodo = abb_obtener_nodo_desde(arbol, dedo, nodo_otro->clave, NULL, NULL);
+        if(!nodo) continue;
+
+        dedo = abb_nodo_siguiente(nodo);
+        if(!dedo)
+            dedo = abb_nodo_anterior(nodo);
+        abb_desenganchar(arbol, nodo);
+        abb_nodo_destruir(arbol, nodo);
+    }
+}
+
+/* Deja en arbol solo las claves que estan en otro (si comunes) o solo las
+que no estan (si no), sin modificar otro */
+bool abb_filtrar_por(abb_t *arbol, const abb_t *otro, bool comunes) {
+    if(!arbol->raiz) return true;
+    if(!comunes && abb_conviene_buscar(otro->tam, arbol->tam))
+    {
+        abb_quitar_de_a_uno(arbol, otro);
+        return true;
+    }
+
+    size_t cantidad = arbol->tam;
+    abb_nodo_t** nodos = malloc(cantidad * sizeof(abb_nodo_t*));
+    if(!nodos) return false;
+    abb_listar_nodos(arbol->raiz, nodos);
+
+    // Si arbol es mucho mas chico, cada clave se busca en otro desde donde
+    // termino la busqueda anterior en lugar de recorrer todo otro
+    bool buscar = abb_conviene_buscar(cantidad, otro->tam);
+    size_t k = 0;
+    abb_nodo_t* nodo_otro = buscar ? NULL : abb_nodo_minimo(otro->raiz);
+    for(size_t i = 0; i < cantidad; i++)
+    {
+        bool esta;
+        if(buscar)
+        {
+            abb_nodo_t* ultimo = NULL;
+            abb_nodo_t* igual = abb_obtener_nodo_desde(otro, nodo_otro, nodos[i]->clave, &ultimo, NULL);
+            esta = igual != NULL;
+            nodo_otro = igual ? igual : ultimo;
+        }
+        else
+        {
+            int comp = 1;
+            while(nodo_otro && (comp = arbol->comparar(nodos[i]->clave, nodo_otro->clave)) > 0)
+                nodo_otro = abb_nodo_siguiente(nodo_otro);
+            esta = nodo_otro && comp == 0;
+        }
+        if(esta == comunes)
+            nodos[k++] = nodos[i];
+        else
+            abb_nodo_destruir(arbol, nodos[i]);
+    }
+    arbol->raiz = abb_nodo_armar_lista(nodos, 0, k, NULL);
+    arbol->tam = k;
+    free(nodos);
+    return true;
+}
+
+bool abb_intersectar(abb_t *arbol, const abb_t *otro) {
+    if(!arbol || !otro) return false;
+    if(arbol == otro) return true;
+    return abb_filtrar_por(arbol, otro, true);
+}
+
+bool abb_diferencia(abb_t *arbol, const abb_t *otro) {
+    if(!arbol || !otro) return false;
+
+    if(arbol == otro)
+    {
+        arbol->tam -= abb_destruir_subarbol(arbol, arbol->raiz);
+        arbol->raiz = NULL;
+        return true;
+    }
+    return abb_filtrar_por(arbol, otro, false);
+}
+
+/* Cuenta los nodos y la memoria del mas chico de dos subarboles
+recorriendolos a la par, en O(min(a, b)) pasos de sucesor */
+size_t abb_contar_menor(const abb_t *arbol, abb_nodo_t* a, abb_nodo_t* b, bool* a_es_menor, size_t* memoria) {
+    a = abb_nodo_minimo(a);
+    b = abb_nodo_minimo(b);
+    size_t cantidad = 0, memoria_a = 0, memoria_b = 0;
+    while(a && b)
+    {
+        memoria_a += abb_nodo_memoria(arbol, a);
+        memoria_b += abb_nodo_memoria(arbol, b);
+        a = abb_nodo_siguiente(a);
+        b = abb_nodo_siguiente(b);
+        cantidad++;
+    }
+    *a_es_menor = !a;
+    *memoria = *a_es_menor ? memoria_a : memoria_b;
+    return cantidad;
+}
+
+abb_t* abb_partir(abb_t *arbol, const char *clave) {
+    if(!arbol || !clave || arbol->lru) return NULL;
+
+    abb_t* mayores = abb_crear(arbol->comparar, arbol->destruir);
+    if(!mayores) return NULL;
+
+    mayores->raiz = abb_nodo_cortar(arbol->comparar, arbol->raiz, clave, &arbol->raiz);
+    arbol->version++;
+
+    if(arbol->filtro)
+    {
+        for(abb_nodo_t* nodo = abb_nodo_minimo(mayores->raiz); nodo; nodo = abb_nodo_siguiente(nodo))
+            abb_filtro_quitar(arbol, nodo->clave);
+    }
+    abb_cache_vaciar(arbol);
+
+    bool menores_es_menor;
+    size_t memoria;
+    size_t cantidad = abb_contar_menor(arbol, arbol->raiz, mayores->raiz, &menores_es_menor, &memoria);
+    mayores->tam = menores_es_menor ? arbol->tam - cantidad : cantidad;
+    mayores->memoria = menores_es_menor ? arbol->memoria - memoria : memoria;
+    arbol->tam -= mayores->tam;
+    arbol->memoria -= mayores->memoria;
+
+    return mayores;
+}
+
+bool abb_juntar(abb_t *arbol, abb_t *otro) {
+    if(!arbol || !otro || arbol == otro || arbol->lru || otro->lru) return false;
+    if(!otro->raiz) return true;
+
+    if(arbol->raiz)
+    {
+        const char* mayor = abb_nodo_maximo(arbol->raiz)->clave;
+        const char* menor = abb_nodo_minimo(otro->raiz)->clave;
+        if(arbol->comparar(mayor, menor) >= 0) return false;
+    }
+
+    abb_filtro_agregar_subarbol(arbol, otro->raiz);
+    if(otro->filtro)
+        filtro_vaciar(otro->filtro);
+    abb_cache_vaciar(otro);
+
+    arbol->raiz = abb_nodo_juntar(arbol->raiz, otro->raiz);
+    arbol->tam += otro->tam;
+    arbol->memoria += otro->memoria;
+    abb_filtro_ajustar(arbol);
+
+    otro->raiz = NULL;
+    otro->tam = 0;
+    otro->memoria = 0;
+    otro->version++;
+    return true;
+}
+
+/*
+La función destruir_dato se recibe en el constructor, para usarla en abb_destruir y en abb_insertar en el caso de que tenga que reemplazar el dato de una clave ya existente.
+
+Por otro lado deben implementar dos iteradores inorder.
+El iterador interno funciona usando la función de callback "visitar" que recibe la clave, el valor y un puntero extra, y devuelve true si se debe seguir iterando, false en caso contrario:
+*/
+
+void abb_in_order(abb_t *arbol, bool visitar(const char *, void *, void *), void *extra) {
+    if(!arbol || !arbol->raiz) return;
+
+    // Se recorre con los punteros al padre: espacio constante y, al devolver
+    // false visitar, se corta el recorrido completo
+    abb_nodo_t* nodo = abb_nodo_minimo(arbol->raiz);
+    while(nodo)
+    {
+        if(!visitar(nodo->clave, nodo->dato, extra)) return;
+        nodo = abb_nodo_siguiente(nodo);
+    }
+}
+
+/* Y un iterador externo: */
+
+/* El iterador solo guarda el nodo actual; avanzar usa el puntero al padre,
+por lo que no pide memoria extra y sobrevive a inserciones en el arbol.
+Cuando actual es NULL, antes_del_inicio distingue si se salio del recorrido
+por la izquierda (retrocediendo) o por la derecha (avanzando) */
+struct abb_iter {
+    const abb_t* arbol;
+    abb_nodo_t* actual;
+    bool antes_del_inicio;
+};
+
+abb_iter_t *abb_iter_in_crear(const abb_t *arbol) {
+    if(!arbol) return NULL;
+
+    abb_iter_t* iter = malloc(sizeof(abb_iter_t));
+    if(!iter) return NULL;
+
+    iter->arbol = arbol;
+    iter->actual = abb_nodo_minimo(arbol->raiz);
+    iter->antes_del_inicio = false;
+
+    return iter;
+}
+
+abb_iter_t *abb_iter_in_crear_reverso(const abb_t *arbol) {
+    if(!arbol) return NULL;
+
+    abb_iter_t* iter = malloc(sizeof(abb_iter_t));
+    if(!iter) return NULL;
+
+    iter->arbol = arbol;
+    iter->actual = abb_nodo_maximo(arbol->raiz);
+    iter->antes_del_inicio = !iter->actual;
+
+    return iter;
+}
+
+bool abb_iter_in_avanzar(abb_iter_t *iter) {
+    if(!iter) return false;
+
+    if(!iter->actual)
+    {
+        // Desde antes del inicio se vuelve a entrar por el menor
+        if(!iter->antes_del_inicio) return false;
+        iter->actual = abb_nodo_minimo(iter->arbol->raiz);
+        iter->antes_del_inicio = false;
+        return true;
+    }
+
+    iter->actual = abb_nodo_siguiente(iter->actual);
+
+    return true;
+}
+
+bool abb_iter_in_retroceder(abb_iter_t *iter) {
+    if(!iter) return false;
+
+    if(!iter->actual)
+    {
+        // Desde el final se vuelve a entrar por el mayor
+        if(iter->antes_del_inicio) return false;
+        iter->actual = abb_nodo_maximo(iter->arbol->raiz);
+        iter->antes_del_inicio = !iter->actual;
+        return true;
+    }
+
+    iter->actual = abb_nodo_anterior(iter->actual);
+    iter->antes_del_inicio = !iter->actual;
+
+    return true;
+}
+
+const char *abb_iter_in_ver_actual(const abb_iter_t *iter) {
+    if(!iter || !iter->actual) return NULL;
+    return iter->actual->clave;
+}
+
+bool abb_iter_in_al_final(const abb_iter_t *iter) {
+    if(!iter) return true;
+    return !iter->actual && !iter->antes_del_inicio;
+}
+
+bool abb_iter_in_al_principio(const abb_iter_t *iter) {
+    if(!iter) return true;
+    return !iter->actual && iter->antes_del_inicio;
+}
+
+void* abb_iter_in_ver_dato(const abb_iter_t *iter) {
+    return iter && iter->actual ? iter->actual->dato : NULL;
+}
+
+bool abb_iter_in_reemplazar_dato(abb_t *arbol, abb_iter_t *iter, void *dato) {
+    if(!arbol || !iter || iter->arbol != arbol || !iter->actual) return false;
+
+    if(arbol->destruir)
+        arbol->destruir(iter->actual->dato);
+    iter->actual->dato = dato;
+    return true;
+}
+
+void* abb_iter_in_borrar_actual(abb_t *arbol, abb_iter_t *iter) {
+    if(!arbol || !iter || iter->arbol != arbol || !iter->actual) return NULL;
+
+    // Desenganchar no mueve a los demas nodos, asi que el sucesor sigue
+    // siendo valido despues de liberar el actual
+    abb_nodo_t* nodo = iter->actual;
+    iter->actual = abb_nodo_siguiente(nodo);
+    void* dato = nodo->dato;
+    abb_desenganchar(arbol, nodo);
+    abb_nodo_liberar(arbol, nodo);
+    return dato;
+}
+
+void abb_iter_in_recorrer(abb_iter_t *iter, bool visitar(const char *, void *, void *), void *extra) {
+    if(!iter) return;
+    if(!iter->actual && !abb_iter_in_avanzar(iter)) return;
+
+    // El iterador avanza antes de visitar, de forma que si visitar devuelve
+    // false la proxima llamada sigue por el siguiente
+    while(iter->actual)
+    {
+        abb_nodo_t* nodo = iter->actual;
+        iter->actual = abb_nodo_siguiente(nodo);
+        if(!visitar(nodo->clave, nodo->dato, extra)) return;
+    }
+}
+
+void abb_iter_in_destruir(abb_iter_t* iter) {
+    free(iter);
+}
+
+size_t abb_borrar_rango(abb_t *arbol, const char *desde, const char *hasta) {
+    if(!arbol || !desde || !hasta || arbol->comparar(desde, hasta) >= 0) return 0;
+
+    // Dos cortes separan el rango en su propio subarbol, y un solo juntar
+    // vuelve a unir lo que queda a cada lado
+    abb_nodo_t *menores, *rango;
+    abb_nodo_t* resto = abb_nodo_cortar(arbol->comparar, arbol->raiz, desde, &menores);
+    abb_nodo_t* mayores = abb_nodo_cortar(arbol->comparar, resto, hasta, &rango);
+    arbol->raiz = abb_nodo_juntar(menores, mayores);
+
+    size_t borrados = abb_destruir_subarbol(arbol, rango);
+    arbol->tam -= borrados;
+    return borrados;
+}
+
+/* ******************************************************************
+ *                       GUARDAR Y BORRAR EN LOTE
+ * *****************************************************************/
+
+/* Ordena los indices de claves con merge sort. Es estable, asi que las
+claves repetidas quedan en el orden en que llegaron */
+bool abb_ordenar_indices(abb_comparar_clave_t cmp, const char *claves[], size_t indices[], size_t cantidad) {
+    size_t* auxiliar = malloc(cantidad * sizeof(size_t));
+    if(!auxiliar) return false;
+
+    for(size_t ancho = 1; ancho < cantidad; ancho *= 2)
+    {
+        for(size_t inicio = 0; inicio < cantidad; inicio += 2 * ancho)
+        {
+            size_t medio = inicio + ancho < cantidad ? inicio + ancho : cantidad;
+            size_t fin = medio + ancho < cantidad ? medio + ancho : cantidad;
+            size_t i = inicio, j = medio, k = inicio;
+            while(i < medio && j < fin)
+                auxiliar[k++] = cmp(claves[indices[j]], claves[indices[i]]) < 0 ? indices[j++] : indices[i++];
+            while(i < medio)
+                auxiliar[k++] = indices[i++];
+            while(j < fin)
+                auxiliar[k++] = indices[j++];
+        }
+        memcpy(indices, auxiliar, cantidad * sizeof(size_t));
+    }
+
+    free(auxiliar);
+    return true;
+}
+
+/* Devuelve los indices de las claves no NULL, ordenados por clave, y deja
+en validas cuantos son. Las claves NULL se descartan antes de comparar */
+size_t* abb_indices_ordenados(abb_comparar_clave_t cmp, const char *claves[], size_t cantidad, size_t* validas) {
+    size_t* indices = malloc(cantidad * sizeof(size_t));
+    if(!indices) return NULL;
+    *validas = 0;
+    for(size_t i = 0; i < cantidad; i++)
+    {
+        if(claves[i])
+            indices[(*validas)++] = i;
+    }
+
+    // Un lote que ya viene ordenado, como el de abb_importar, no se ordena
+    size_t ordenadas = 1;
+    while(ordenadas < *validas && cmp(claves[indices[ordenadas - 1]], claves[indices[ordenadas]]) <= 0)
+        ordenadas++;
+    if(ordenadas < *validas && !abb_ordenar_indices(cmp, claves, indices, *validas))
+    {
+        free(indices);
+        return NULL;
+    }
+    return indices;
+}
+
+/* Arma un subarbol balanceado con nodos[inicio, fin), que estan en orden */
+abb_nodo_t* abb_nodo_armar(abb_nodo_t* nodos, size_t inicio, size_t fin, abb_nodo_t* padre) {
+    if(inicio >= fin) return NULL;
+
+    size_t medio = inicio + (fin - inicio) / 2;
+    abb_nodo_t* nodo = &nodos[medio];
+    nodo->padre = padre;
+    nodo->izq = abb_nodo_armar(nodos, inicio, medio, nodo);
+    nodo->der = abb_nodo_armar(nodos, medio + 1, fin, nodo);
+    return nodo;
+}
+
+/* abb_guardar_lote de un abb acotado: cada clave se guarda con su propio
+malloc, buscando desde la anterior. El dedo es siempre el ultimo nodo
+guardado, que el desalojo no toca */
+size_t abb_guardar_lote_acotado(abb_t *arbol, const char *claves[], void *datos[], const size_t* indices, size_t validas, bool resultados[]) {
+    size_t guardados = 0;
+    abb_nodo_t* dedo = NULL;
+    for(size_t i = 0; i < validas; i++)
+    {
+        size_t actual = indices[i];
+        abb_nodo_t* nodo = abb_guardar_desde(arbol, dedo, claves[actual], datos[actual], 0);
+        if(!nodo) continue;
+        dedo = nodo;
+        if(resultados)
+            resultados[actual] = true;
+        guardados++;
+    }
+    return guardados;
+}
+
+size_t abb_guardar_lote(abb_t *arbol, const char *claves[], void *datos[], size_t cantidad, bool resultados[]) {
+    if(resultados)
+    {
+        for(size_t i = 0; i < cantidad; i++)
+            resultados[i] = false;
+    }
+    if(!arbol || !claves || !cantidad) return 0;
+
+    size_t validas;
+    size_t* indices = abb_indices_ordenados(arbol->comparar, claves, cantidad, &validas);
+    if(!indices) return 0;
+
+    if(arbol->lru)
+    {
+        size_t guardados = abb_guardar_lote_acotado(arbol, claves, datos, indices, validas, resultados);
+        free(indices);
+        return guardados;
+    }
+
+    // 1) Se reemplazan los datos de las claves que ya estan, buscando cada
+    // una desde la anterior. Las nuevas quedan marcadas para el paso 2
+    size_t guardados = 0, nuevos = 0, largo_claves = 0;
+    abb_nodo_t* dedo = NULL;
+    for(size_t i = 0; i < validas; i++)
+    {
+        size_t actual = indices[i];
+        abb_nodo_t* nodo = abb_obtener_nodo_desde(arbol, dedo, claves[actual], NULL, NULL);
+        if(nodo)
+        {
+            if(arbol->destruir)
+                arbol->destruir(nodo->dato);
+            nodo->dato = datos[actual];
+            dedo = nodo;
+        }
+        else
+        {
+            // Una clave repetida en el lote solo cuenta la primera vez
+            if(i + 1 < validas && arbol->comparar(claves[actual], claves[indices[i + 1]]) == 0)
+            {
+                if(arbol->destruir)
+                    arbol->destruir(datos[actual]);
+                if(resultados)
+                    resultados[actual] = true;
+                guardados++;
+                continue;
+            }
+            indices[nuevos++] = actual;
+            largo_claves += strlen(claves[actual]) + 1;
+            continue;
+        }
+        if(resultados)
+            resultados[actual] = true;
+        guardados++;
+    }
+
+    // 2) Todos los nodos nuevos y sus claves salen de un solo bloque
+    abb_bloque_t* bloque = nuevos ? malloc(sizeof(abb_bloque_t) + nuevos * sizeof(abb_nodo_t) + largo_claves) : NULL;
+    if(!bloque)
+    {
+        free(indices);
+        return guardados;
+    }
+    bloque->vivos = nuevos;
+    char* clave_copiada = (char*) (bloque->nodos + nuevos);
+
+    for(size_t i = 0; i < nuevos; i++)
+    {
+        size_t actual = indices[i];
+        abb_nodo_t* nodo = &bloque->nodos[i];
+        strcpy(clave_copiada, claves[actual]);
+        nodo->clave = clave_copiada;
+        clave_copiada += strlen(clave_copiada) + 1;
+        nodo->dato = datos[actual];
+        nodo->bloque = bloque;
+        abb_filtro_agregar(arbol, nodo->clave);
+        if(resultados)
+            resultados[actual] = true;
+    }
+
+    // 3) Las claves nuevas que caen en el mismo hueco del arbol son una tira
+    // contigua del lote ordenado: se busca el hueco una sola vez y se cuelga
+    // ahi la tira armada como subarbol balanceado
+    dedo = NULL;
+    for(size_t inicio = 0; inicio < nuevos; )
+    {
+        abb_nodo_t* padre = NULL;
+        abb_nodo_t** enlace = &arbol->raiz;
+        abb_obtener_nodo_desde(arbol, dedo, bloque->nodos[inicio].clave, &padre, &enlace);
+
+        // La tira termina en la primera clave que no es menor al sucesor del hueco
+        abb_nodo_t* cota = NULL;
+        if(padre)
+            cota = enlace == &padre->izq ? padre : abb_nodo_siguiente(padre);
+        size_t fin = inicio + 1;
+        while(fin < nuevos && (!cota || arbol->comparar(bloque->nodos[fin].clave, cota->clave) < 0))
+            fin++;
+
+        *enlace = abb_nodo_armar(bloque->nodos, inicio, fin, padre);
+        dedo = &bloque->nodos[fin - 1];
+        inicio = fin;
+    }
+
+    arbol->tam += nuevos;
+    arbol->memoria += nuevos * sizeof(abb_nodo_t) + largo_claves;
+    guardados += nuevos;
+    abb_filtro_ajustar(arbol);
+    free(indices);
+    return guardados;
+}
+
+size_t abb_borrar_lote(abb_t *arbol, const char *claves[], size_t cantidad, void *datos[]) {
+    if(datos)
+    {
+        for(size_t i = 0; i < cantidad; i++)
+            datos[i] = NULL;
+    }
+    if(!arbol || !claves || !cantidad) return 0;
+
+    size_t validas;
+    size_t* indices = abb_indices_ordenados(arbol->comparar, claves, cantidad, &validas);
+    if(!indices) return 0;
+
+    size_t borrados = 0;
+    abb_nodo_t* dedo = NULL;
+    for(size_t i = 0; i < validas && arbol->raiz; i++)
+    {
+        size_t actual = indices[i];
+        if(!abb_filtro_puede_estar(arbol, claves[actual])) continue;
+
+        abb_nodo_t* nodo = abb_obtener_nodo_desde(arbol, dedo, claves[actual], NULL, NULL);
+        if(!nodo) continue;
+
+        // El sucesor no se mueve al borrar, y es donde empieza la proxima busqueda
+        dedo = abb_nodo_siguiente(nodo);
+        if(!dedo)
+            dedo = abb_nodo_anterior(nodo);
+        abb_desenganchar(arbol, nodo);
+
+        // Igual que en abb_borrar, una clave vencida ya no estaba
+        if(abb_nodo_vencido(arbol, nodo))
+        {
+            abb_nodo_destruir(arbol, nodo);
+            continue;
+        }
+        if(datos)
+            datos[actual] = nodo->dato;
+        abb_nodo_liberar(arbol, nodo);
+        borrados++;
+    }
+
+    free(indices);
+    return borrados;
+}
+
+/* ******************************************************************
+ *                 COMPACTACION DE NODOS EN MEMORIA
+ * *****************************************************************/
+
+/* Despues de muchos guardar y borrar, los nodos y sus claves quedan
+repartidos por todo el heap. abb_compactar los copia, de a tramos de
+claves consecutivas, a bloques nuevos en orden in-order, con las claves
+a continuacion de los nodos. Asi un recorrido lee memoria contigua y cada
+subarbol de hasta un tramo de nodos queda junto para las busquedas.
+
+Entre tramos solo se recuerda la ultima clave movida, de forma que el abb
+se puede modificar libremente entre una llamada y la siguiente. */
+
+/* Mueve el nodo a destino con su clave en clave, arreglando todos los
+punteros que lo apuntaban, y libera el original */
+void abb_nodo_reubicar(abb_t *arbol, abb_nodo_t* nodo, abb_nodo_t* destino, char* clave, abb_bloque_t* bloque) {
+    memcpy(destino, nodo, abb_nodo_tamanio(arbol));
+    strcpy(clave, nodo->clave);
+    destino->clave = clave;
+    destino->bloque = bloque;
+
+    if(!nodo->padre)
+        arbol->raiz = destino;
+    else if(nodo->padre->izq == nodo)
+        nodo->padre->izq = destino;
+    else
+        nodo->padre->der = destino;
+    if(nodo->izq)
+        nodo->izq->padre = destino;
+    if(nodo->der)
+        nodo->der->padre = destino;
+
+    if(arbol->lru)
+    {
+        abb_nodo_acotado_t* viejo = abb_nodo_acotado(nodo);
+        abb_nodo_acotado_t* nuevo = abb_nodo_acotado(destino);
+        if(viejo->lru_ant)
+            viejo->lru_ant->lru_sig = nuevo;
+        else if(arbol->lru->primero == viejo)
+            arbol->lru->primero = nuevo;
+        if(viejo->lru_sig)
+            viejo->lru_sig->lru_ant = nuevo;
+        else if(arbol->lru->ultimo == viejo)
+            arbol->lru->ultimo = nuevo;
+    }
+    if(arbol->cache)
+    {
+        abb_nodo_t** entrada = &arbol->cache[abb_hash_clave(clave) & arbol->mascara_cache];
+        if(*entrada == nodo)
+            *entrada = destino;
+    }
+
+    abb_nodo_liberar_memoria(nodo);
+}
+
+/* Termina la compactacion y devuelve al sistema la memoria libre del heap */
+void abb_compactacion_terminar(abb_t *arbol) {
+    free(arbol->compactado_hasta);
+    arbol->compactado_hasta = NULL;
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+/* Mueve los cantidad nodos desde inicio, en orden, a un bloque nuevo.
+Devuelve el ultimo nodo movido, o NULL si no hubo memoria */
+abb_nodo_t* abb_compactar_en_bloque(abb_t *arbol, abb_nodo_t* inicio, size_t cantidad, size_t largo_claves) {
+    abb_bloque_t* bloque = malloc(sizeof(abb_bloque_t) + cantidad * sizeof(abb_nodo_t) + largo_claves);
+    if(!bloque) return NULL;
+    bloque->vivos = cantidad;
+    char* clave = (char*) (bloque->nodos + cantidad);
+
+    abb_nodo_t* nodo = inicio;
+    for(size_t i = 0; i < cantidad; i++)
+    {
+        abb_nodo_reubicar(arbol, nodo, &bloque->nodos[i], clave, bloque);
+        clave += strlen(clave) + 1;
+        nodo = abb_nodo_siguiente(&bloque->nodos[i]);
+    }
+    return &bloque->nodos[cantidad - 1];
+}
+
+/* Como abb_compactar_en_bloque, pero cada nodo y su clave van a su propio
+malloc, como piden los abbs acotados (ver abb_bloque). Si no hay memoria
+deja movidos los anteriores y devuelve NULL */
+abb_nodo_t* abb_compactar_de_a_uno(abb_t *arbol, abb_nodo_t* inicio, size_t cantidad) {
+    abb_nodo_t* nodo = inicio;
+    abb_nodo_t* destino = NULL;
+    for(size_t i = 0; i < cantidad; i++)
+    {
+        destino = malloc(abb_nodo_tamanio(arbol));
+        char* clave = malloc(strlen(nodo->clave) + 1);
+        if(!destino || !clave)
+        {
+            free(destino);
+            free(clave);
+            return NULL;
+        }
+        abb_nodo_reubicar(arbol, nodo, destino, clave, NULL);
+        nodo = abb_nodo_siguiente(destino);
+    }
+    return destino;
+}
+
+bool abb_compactar(abb_t *arbol, size_t maximo) {
+    if(!arbol) return false;
+
+    // El tramo empieza en la primera clave mayor a la ultima movida
+    abb_nodo_t* inicio = abb_nodo_cota_inferior(arbol, arbol->compactado_hasta, true);
+
+    size_t cantidad = 0, largo_claves = 0;
+    abb_nodo_t* fin = inicio;
+    for(; fin && (maximo == 0 || cantidad < maximo); fin = abb_nodo_siguiente(fin))
+    {
+        largo_claves += strlen(fin->clave) + 1;
+        cantidad++;
+    }
+    if(cantidad == 0)
+    {
+        abb_compactacion_terminar(arbol);
+        return false;
+    }
+
+    char* hasta = fin ? malloc(strlen(abb_nodo_anterior(fin)->clave) + 1) : NULL;
+    if(fin && !hasta) return false;
+
+    abb_nodo_t* ultimo;
+    if(arbol->lru)
+        ultimo = abb_compactar_de_a_uno(arbol, inicio, cantidad);
+    else
+        ultimo = abb_compactar_en_bloque(arbol, inicio, cantidad, largo_claves);
+    arbol->version++;
+
+    if(!ultimo)
+    {
+        free(hasta);
+        return false;
+    }
+    if(!fin)
+    {
+        abb_compactacion_terminar(arbol);
+        return false;
+    }
+    strcpy(hasta, ultimo->clave);
+    free(arbol->compactado_hasta);
+    arbol->compactado_hasta = hasta;
+    return true;
+}
+
+/* ******************************************************************
+ *                  ABB CONGELADO (SOLO LECTURA)
+ * *****************************************************************/
+
+/* Los elementos se guardan en un arreglo en orden de Eytzinger: la raiz en
+la posicion 1 y los hijos de k en 2k y 2k+1, sin punteros. Los primeros
+niveles, que toda busqueda visita, quedan juntos al principio del arreglo.
+Las claves se copian a un unico bloque en ese mismo orden y cada posicion
+guarda su desplazamiento dentro del bloque. */
+struct abb_congelado {
+    abb_comparar_clave_t comparar;
+    abb_destruir_dato_t destruir;
+    size_t tam;
+    size_t* desplazamientos;  // desplazamientos[k]: clave k dentro de claves
+    void** datos;
+    char* claves;
+    size_t largo_claves;
+};
+
+#ifdef __GNUC__
+#define ABB_PREFETCH(direccion) __builtin_prefetch(direccion)
+#else
+#define ABB_PREFETCH(direccion) ((void) 0)
+#endif
+
+/* Primera posicion in-order del arbol implicito: la mas a la izquierda */
+size_t eytzinger_primero(size_t tam) {
+    if(!tam) return 0;
+    size_t k = 1;
+    while(2 * k <= tam)
+        k *= 2;
+    return k;
+}
+
+/* Siguiente posicion in-order del arbol implicito, o 0 al terminar */
+size_t eytzinger_siguiente(size_t k, size_t tam) {
+    if(2 * k + 1 <= tam)
+    {
+        k = 2 * k + 1;
+        while(2 * k <= tam)
+            k *= 2;
+        return k;
+    }
+    // Sube mientras venga desde un hijo derecho
+    while(k & 1)
+        k >>= 1;
+    return k >> 1;
+}
+
+abb_congelado_t* abb_congelar(abb_t *arbol) {
+    if(!arbol) return NULL;
+
+    // Las vencidas se saltean al copiar y se purgan recien cuando ya no puede
+    // fallar nada, con la misma hora para que ambos pasos coincidan
+    time_t ahora = time(NULL);
+    size_t tam = 0;
+    for(abb_nodo_t* nodo = abb_nodo_minimo(arbol->raiz); nodo; nodo = abb_nodo_siguiente(nodo))
+        tam += !abb_nodo_vencido_en(arbol, nodo, ahora);
+
+    abb_congelado_t* congelado = malloc(sizeof(abb_congelado_t));
+    if(!congelado) return NULL;
+
+    congelado->desplazamientos = malloc((tam + 1) * sizeof(size_t));
+    congelado->datos = malloc((tam + 1) * sizeof(void*));
+    if(!congelado->desplazamientos || !congelado->datos)
+    {
+        free(congelado->desplazamientos);
+        free(congelado->datos);
+        free(congelado);
+        return NULL;
+    }
+
+    // 1) Se recorren a la par el abb y el arbol implicito, ambos in-order,
+    // anotando el largo de cada clave en su posicion
+    size_t k = eytzinger_primero(tam);
+    for(abb_nodo_t* nodo = abb_nodo_minimo(arbol->raiz); nodo; nodo = abb_nodo_siguiente(nodo))
+    {
+        if(abb_nodo_vencido_en(arbol, nodo, ahora)) continue;
+        congelado->desplazamientos[k] = strlen(nodo->clave) + 1;
+        congelado->datos[k] = nodo->dato;
+        k = eytzinger_siguiente(k, tam);
+    }
+
+    // 2) Los largos pasan a ser desplazamientos dentro del bloque
+    size_t largo_claves = 0;
+    for(k = 1; k <= tam; k++)
+    {
+        size_t largo = congelado->desplazamientos[k];
+        congelado->desplazamientos[k] = largo_claves;
+        largo_claves += largo;
+    }
+
+    congelado->claves = malloc(largo_claves ? largo_claves : 1);
+    if(!congelado->claves)
+    {
+        free(congelado->desplazamientos);
+        free(congelado->datos);
+        free(congelado);
+        return NULL;
+    }
+    abb_purgar_vencidos_en(arbol, ahora);
+
+    // 3) Se copian las claves
+    k = eytzinger_primero(tam);
+    for(abb_nodo_t* nodo = abb_nodo_minimo(arbol->raiz); nodo; nodo = abb_nodo_siguiente(nodo))
+    {
+        strcpy(congelado->claves + congelado->desplazamientos[k], nodo->clave);
+        k = eytzinger_siguiente(k, tam);
+    }
+
+    congelado->comparar = arbol->comparar;
+    congelado->destruir = arbol->destruir;
+    congelado->tam = tam;
+    congelado->largo_claves = largo_claves;
+
+    // Los datos pasan a ser del congelado
+    abb_filtro_desactivar(arbol);
+    abb_cache_desactivar(arbol);
+    arbol->destruir = NULL;
+    abb_destruir(arbol);
+
+    return congelado;
+}
+
+/* Busca la posicion de la menor clave mayor o igual a clave. El descenso no
+sale antes al encontrarla, asi que cada nivel hace el mismo trabajo, y se
+pide a cache el bloque de desplazamientos de tres niveles mas abajo */
+size_t abb_congelado_buscar(const abb_congelado_t *congelado, const char *clave) {
+    size_t k = 1;
+    while(k <= congelado->tam)
+    {
+        ABB_PREFETCH(congelado->desplazamientos + 8 * k);
+        const char* actual = congelado->claves + congelado->desplazamientos[k];
+        k = 2 * k + (congelado->comparar(clave, actual) > 0);
+    }
+    // Se deshacen los pasos a la derecha y uno a la izquierda mas
+    while(k & 1)
+        k >>= 1;
+    k >>= 1;
+
+    if(!k || congelado->comparar(clave, congelado->claves + congelado->desplazamientos[k]) != 0)
+        return 0;
+    return k;
+}
+
+void *abb_congelado_obtener(const abb_congelado_t *congelado, const char *clave) {
+    if(!congelado || !clave) return NULL;
+    size_t k = abb_congelado_buscar(congelado, clave);
+    return k ? congelado->datos[k] : NULL;
+}
+
+bool abb_congelado_pertenece(const abb_congelado_t *congelado, const char *clave) {
+    if(!congelado || !clave) return false;
+    return abb_congelado_buscar(congelado, clave) != 0;
+}
+
+size_t abb_congelado_cantidad(const abb_congelado_t *congelado) {
+    return congelado->tam;
+}
+
+size_t abb_congelado_memoria(const abb_congelado_t *congelado) {
+    if(!congelado) return 0;
+    return sizeof(abb_congelado_t) + (congelado->tam + 1) * (sizeof(size_t) + sizeof(void*)) + congelado->largo_claves;
+}
+
+void abb_congelado_in_order(const abb_congelado_t *congelado, bool visitar(const char *, void *, void *), void *extra) {
+    if(!congelado) return;
+    for(size_t k = eytzinger_primero(congelado->tam); k; k = eytzinger_siguiente(k, congelado->tam))
+    {
+        if(!visitar(congelado->claves + congelado->desplazamientos[k], congelado->datos[k], extra))
+            return;
+    }
+}
+
+void abb_congelado_destruir(abb_congelado_t *congelado) {
+    if(!congelado) return;
+    if(congelado->destruir)
+    {
+        for(size_t k = 1; k <= congelado->tam; k++)
+            congelado->destruir(congelado->datos[k]);
+    }
+    free(congelado->desplazamientos);
+    free(congelado->datos);
+    free(congelado->claves);
+    free(congelado);
+}
+
+/* ******************************************************************
+ *                  EXPORTAR E IMPORTAR EN ARREGLOS
+ * *****************************************************************/
+
+size_t abb_exportar(const abb_t *arbol, const char *desde, const char *hasta, const char *claves[], size_t largos[], void *datos[], size_t capacidad) {
+    if(!arbol) return 0;
+
+    size_t cantidad = 0;
+    abb_nodo_t* nodo = abb_nodo_cota_inferior(arbol, desde, false);
+    for(; nodo && cantidad < capacidad; nodo = abb_nodo_siguiente(nodo), cantidad++)
+    {
+        if(hasta && arbol->comparar(nodo->clave, hasta) >= 0)
+            break;
+        if(claves)
+            claves[cantidad] = nodo->clave;
+        if(largos)
+            largos[cantidad] = strlen(nodo->clave);
+        if(datos)
+            datos[cantidad] = nodo->dato;
+    }
+    return cantidad;
+}
+
+abb_exportacion_t* abb_exportar_rango(const abb_t *arbol, const char *desde, const char *hasta) {
+    if(!arbol) return NULL;
+
+    size_t cantidad = arbol->tam;
+    if(desde || hasta)
+        cantidad = abb_exportar(arbol, desde, hasta, NULL, NULL, NULL, arbol->tam);
+
+    // Un solo malloc con los tres arreglos a continuacion del struct
+    abb_exportacion_t* exportacion = malloc(sizeof(abb_exportacion_t) + cantidad * (sizeof(char*) + sizeof(void*) + sizeof(size_t)));
+    if(!exportacion) return NULL;
+
+    exportacion->claves = (const char**) (exportacion + 1);
+    exportacion->datos = (void**) (exportacion->claves + cantidad);
+    exportacion->largos = (size_t*) (exportacion->datos + cantidad);
+    exportacion->cantidad = abb_exportar(arbol, desde, hasta, exportacion->claves, exportacion->largos, exportacion->datos, cantidad);
+    return exportacion;
+}
+
+void abb_exportacion_destruir(abb_exportacion_t *exportacion) {
+    free(exportacion);
+}
+
+size_t abb_importar(abb_t *arbol, const abb_exportacion_t *exportacion) {
+    if(!arbol || !exportacion) return 0;
+    return abb_guardar_lote(arbol, exportacion->claves, exportacion->datos, exportacion->cantidad, NULL);
+}
+
+/* ******************************************************************
+ *                  CURSOR DE BUSQUEDA CON DEDO
+ * *****************************************************************/
+
+/* El cursor recuerda el ultimo nodo visitado y empieza la siguiente
+busqueda desde ahi, subiendo solo hasta el ancestro que acota la clave.
+Con claves cercanas una de otra cada busqueda cuesta O(log d) en la
+distancia d, en lugar de bajar siempre desde la raiz. */
+
+struct abb_cursor {
+    abb_t* arbol;
+    abb_nodo_t* dedo;
+    size_t version;         // version del abb cuando se tomo el dedo
+};
+
+abb_cursor_t* abb_cursor_crear(abb_t *arbol) {
+    if(!arbol) return NULL;
+
+    abb_cursor_t* cursor = malloc(sizeof(abb_cursor_t));
+    if(!cursor) return NULL;
+
+    cursor->arbol = arbol;
+    cursor->dedo = NULL;
+    cursor->version = arbol->version;
+    return cursor;
+}
+
+/* Devuelve el dedo, o NULL si desde que se tomo se libero o se saco algun
+nodo del abb y puede no estar mas */
+abb_nodo_t* abb_cursor_dedo(const abb_cursor_t *cursor) {
+    return cursor->version == cursor->arbol->version ? cursor->dedo : NULL;
+}
+
+void abb_cursor_mover(abb_cursor_t *cursor, abb_nodo_t* dedo) {
+    cursor->dedo = dedo;
+    cursor->version = cursor->arbol->version;
+}
+
+/* Busca desde el dedo y lo deja en el nodo encontrado o, si la clave no
+esta, en el ultimo nodo visitado */
+abb_nodo_t* abb_cursor_buscar(abb_cursor_t *cursor, const char *clave) {
+    abb_t* arbol = cursor->arbol;
+    if(!arbol->raiz || (arbol->filtro && !abb_filtro_puede_estar(arbol, clave)))
+        return NULL;
+
+    abb_nodo_t* ultimo = NULL;
+    abb_nodo_t* nodo = abb_obtener_nodo_desde(arbol, abb_cursor_dedo(cursor), clave, &ultimo, NULL);
+    abb_cursor_mover(cursor, nodo ? nodo : ultimo);
+    if(!nodo || abb_nodo_vencido(arbol, nodo))
+        return NULL;
+    if(arbol->lru)
+        abb_lru_usar(arbol->lru, nodo);
+    return nodo;
+}
+
+void* abb_cursor_obtener(abb_cursor_t *cursor, const char *clave) {
+    if(!cursor || !clave) return NULL;
+    abb_nodo_t* nodo = abb_cursor_buscar(cursor, clave);
+    return nodo ? nodo->dato : NULL;
+}
+
+bool abb_cursor_pertenece(abb_cursor_t *cursor, const char *clave) {
+    if(!cursor || !clave) return false;
+    return abb_cursor_buscar(cursor, clave) != NULL;
+}
+
+bool abb_cursor_guardar(abb_cursor_t *cursor, const char *clave, void *dato) {
+    if(!cursor || !clave) return false;
+    abb_nodo_t* nodo = abb_guardar_desde(cursor->arbol, abb_cursor_dedo(cursor), clave, dato, 0);
+    if(!nodo) return false;
+    abb_cursor_mover(cursor, nodo);
+    return true;
+}
+
+void abb_cursor_destruir(abb_cursor_t *cursor) {
+    free(cursor);
 }
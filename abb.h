@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stdlib.h>
+#include <time.h>
 
 typedef struct abb abb_t;
 
@@ -13,9 +14,27 @@ typedef void (*abb_destruir_dato_t) (void *);
 /* Crea un abb vacio con funcion de comparacion y destruccion de datos*/
 abb_t* abb_crear(abb_comparar_clave_t cmp, abb_destruir_dato_t destruir_dato);
 
+/* Crea un abb acotado, para usar como cache ordenada: al superar
+max_elementos o max_memoria bytes de nodos y claves (0 es sin limite),
+abb_guardar desaloja las claves usadas hace mas tiempo, destruyendo sus
+datos. Consultar o guardar una clave la marca como usada. abb_unir,
+abb_partir y abb_juntar no se permiten sobre abbs acotados*/
+abb_t* abb_crear_acotado(abb_comparar_clave_t cmp, abb_destruir_dato_t destruir_dato, size_t max_elementos, size_t max_memoria);
+
 /* Guarda clave/dato en abb */
 bool abb_guardar(abb_t *arbol, const char *clave, void *dato);
 
+/* Guarda clave/dato en abb, con un vencimiento (0 es sin vencimiento). A
+partir de ese momento la clave no se encuentra con abb_obtener,
+abb_pertenece ni abb_borrar, y se libera al desalojarse, al volver a
+guardarla o con abb_purgar_vencidos. Los iteradores todavia la recorren.
+Solo los abbs acotados guardan vencimientos (con ambos limites en 0 no
+desalojan nada): en los demas devuelve false si vencimiento no es 0 */
+bool abb_guardar_con_vencimiento(abb_t *arbol, const char *clave, void *dato, time_t vencimiento);
+
+/* Borra las claves vencidas destruyendo sus datos, y devuelve cuantas */
+size_t abb_purgar_vencidos(abb_t *arbol);
+
 /*Borra por clave en abb, devuelve dato*/
 void *abb_borrar(abb_t *arbol, const char *clave);
 
@@ -29,9 +48,140 @@ bool abb_pertenece(const abb_t *arbol, const char *clave);
 /*Devuelve size_t de la cantidad de elementos en el abb*/
 size_t abb_cantidad(abb_t *arbol);
 
+/*Devuelve los bytes que ocupan los nodos y las claves del abb*/
+size_t abb_memoria(const abb_t *arbol);
+
+/*Copia los nodos y las claves del abb a memoria contigua en orden (en un
+abb acotado, cada nodo a su propio malloc, tambien en orden), de a
+tramos de hasta maximo nodos (0 es todo el abb de una vez), y devuelve al
+sistema la memoria que se libera. Devuelve true si todavia queda parte del
+abb por compactar; la siguiente llamada sigue donde quedo, aunque el abb se
+haya modificado en el medio. Invalida los iteradores del abb*/
+bool abb_compactar(abb_t *arbol, size_t maximo);
+
+/*Devuelve la menor clave del abb en O(altura), o NULL si esta vacio*/
+const char *abb_minimo(const abb_t *arbol);
+
+/*Devuelve la mayor clave del abb en O(altura), o NULL si esta vacio*/
+const char *abb_maximo(const abb_t *arbol);
+
 /*destruye el abb*/
 void abb_destruir(abb_t *arbol);
 
+/*Guarda cantidad pares claves[i]/datos[i], como llamar a abb_guardar con
+cada uno en orden, pero ordenando antes el lote para buscar cada clave desde
+la anterior y pidiendo la memoria de todos los nodos nuevos de una vez
+(salvo en un abb acotado, donde cada nodo se pide por separado para que
+desalojarlo devuelva su memoria).
+Si resultados no es NULL, resultados[i] indica si se guardo claves[i].
+Devuelve la cantidad de pares guardados*/
+size_t abb_guardar_lote(abb_t *arbol, const char *claves[], void *datos[], size_t cantidad, bool resultados[]);
+
+/*Borra las claves del lote, como llamar a abb_borrar con cada una en orden.
+Si datos no es NULL, datos[i] es el dato de claves[i] o NULL si no estaba.
+Devuelve la cantidad de claves borradas*/
+size_t abb_borrar_lote(abb_t *arbol, const char *claves[], size_t cantidad, void *datos[]);
+
+/* Contenido de un abb en arreglos contiguos, en orden: claves[i] apunta a
+la clave dentro del abb, de largo largos[i], y datos[i] es su dato. Las
+claves dejan de ser validas al borrarlas o compactar el abb */
+typedef struct abb_exportacion {
+    const char **claves;
+    size_t *largos;
+    void **datos;
+    size_t cantidad;
+} abb_exportacion_t;
+
+/*Copia en orden las claves del rango [desde, hasta), sus largos y sus datos
+a los arreglos recibidos, hasta capacidad elementos, y devuelve cuantos
+copio. desde o hasta NULL dejan el rango abierto de ese lado, y cualquiera
+de los arreglos puede ser NULL*/
+size_t abb_exportar(const abb_t *arbol, const char *desde, const char *hasta, const char *claves[], size_t largos[], void *datos[], size_t capacidad);
+
+/*Como abb_exportar, pero pide la memoria de los arreglos justa para todo el
+rango. Devuelve NULL en caso de error*/
+abb_exportacion_t* abb_exportar_rango(const abb_t *arbol, const char *desde, const char *hasta);
+
+/*Destruye la exportacion, sin tocar claves ni datos*/
+void abb_exportacion_destruir(abb_exportacion_t *exportacion);
+
+/*Guarda todos los pares de la exportacion con abb_guardar_lote. Como las
+claves ya vienen ordenadas no se ordenan, y los nodos nuevos se piden de
+una vez; cada clave igual se busca en el abb, desde la anterior.
+Devuelve la cantidad guardada.
+Pre: los datos pasan a ser de este abb. O el abb exportado no tiene
+funcion de destruccion, o sus claves se sacan con abb_borrar (que no
+destruye los datos) antes de destruirlo, para no destruirlos dos veces*/
+size_t abb_importar(abb_t *arbol, const abb_exportacion_t *exportacion);
+
+/* Filtro de pertenencia aproximada delante del arbol. Con el filtro activo,
+abb_obtener, abb_pertenece y abb_borrar descartan la mayoria de las claves
+ausentes leyendo una sola linea de cache, sin bajar por el arbol. El filtro
+se mantiene al guardar y borrar y se agranda solo si el arbol lo supera.
+Pre: dos claves son iguales segun la funcion de comparacion solo si son
+iguales byte a byte, ya que el filtro trabaja sobre un hash de los bytes. */
+
+typedef struct abb_filtro_estadisticas {
+    size_t memoria;                 // bytes que ocupa el filtro
+    size_t capacidad;               // elementos para los que esta dimensionado
+    size_t funciones_hash;          // hashes derivados por clave
+    double tasa_falsos_positivos;   // esperada con la cantidad actual
+} abb_filtro_estadisticas_t;
+
+/*Activa el filtro dimensionado para capacidad elementos (o la cantidad
+actual, si es mayor) con la tasa de falsos positivos pedida, entre 0 y 1.
+Si ya estaba activo lo rearma. Devuelve false en caso de error*/
+bool abb_filtro_activar(abb_t *arbol, size_t capacidad, double tasa_falsos_positivos);
+
+/*Desactiva el filtro y libera su memoria*/
+void abb_filtro_desactivar(abb_t *arbol);
+
+/*Completa estadisticas con los datos del filtro. Devuelve false si el filtro
+no esta activo*/
+bool abb_filtro_estadisticas(const abb_t *arbol, abb_filtro_estadisticas_t *estadisticas);
+
+/* Cache de claves frecuentes delante del arbol, para accesos sesgados en
+los que unas pocas claves se llevan la mayoria de las consultas. Las claves
+encontradas hace poco se resuelven con un hash y una comparacion.
+Pre: igual que con el filtro, claves iguales segun la comparacion deben ser
+iguales byte a byte. */
+
+/*Activa la cache con entradas posiciones (se redondea a potencia de dos).
+Si ya estaba activa la reemplaza vacia. Devuelve false en caso de error*/
+bool abb_cache_activar(abb_t *arbol, size_t entradas);
+
+/*Desactiva la cache y libera su memoria*/
+void abb_cache_desactivar(abb_t *arbol);
+
+/* Operaciones de conjunto. Mueven nodos entre arboles en lugar de copiar
+claves. Pre: ambos arboles usan la misma funcion de comparacion y de
+destruccion de datos. */
+
+/*Mueve todos los elementos de otro a arbol, que queda vacio. Si una clave
+esta en ambos queda el dato de otro y se destruye el de arbol*/
+bool abb_unir(abb_t *arbol, abb_t *otro);
+
+/*Deja en arbol solo las claves que tambien estan en otro, destruyendo los
+datos que se quitan. otro no se modifica*/
+bool abb_intersectar(abb_t *arbol, const abb_t *otro);
+
+/*Quita de arbol las claves que estan en otro, destruyendo sus datos.
+otro no se modifica*/
+bool abb_diferencia(abb_t *arbol, const abb_t *otro);
+
+/*Mueve a un abb nuevo las claves mayores o iguales a clave y lo devuelve.
+En arbol quedan solo las menores. Devuelve NULL en caso de error*/
+abb_t* abb_partir(abb_t *arbol, const char *clave);
+
+/*Mueve todos los elementos de otro al final de arbol, que queda vacio.
+Devuelve false si alguna clave de arbol no es menor a todas las de otro*/
+bool abb_juntar(abb_t *arbol, abb_t *otro);
+
+/*Borra las claves en el rango [desde, hasta) destruyendo sus datos, y
+devuelve cuantas borro. Separa el rango como un subarbol en O(altura) y lo
+libera entero, sin buscar cada clave*/
+size_t abb_borrar_rango(abb_t *arbol, const char *desde, const char *hasta);
+
 /*
 La función destruir_dato se recibe en el constructor, para usarla en abb_destruir y en abb_insertar en el caso de que tenga que reemplazar el dato de una clave ya existente.
 
@@ -50,16 +200,94 @@ typedef struct abb_iter abb_iter_t;
 del abb, es decir el mas chico*/
 abb_iter_t *abb_iter_in_crear(const abb_t *arbol);
 
+/*Crea el iterador posicionando en el nodo mas a la der
+del abb, es decir el mas grande, para recorrerlo con abb_iter_in_retroceder*/
+abb_iter_t *abb_iter_in_crear_reverso(const abb_t *arbol);
+
 /*Avanza el iterador*/
 bool abb_iter_in_avanzar(abb_iter_t *iter);
 
+/*Retrocede el iterador. Desde el final vuelve al mayor elemento*/
+bool abb_iter_in_retroceder(abb_iter_t *iter);
+
 /*Devuelve el elemento en el que el iterador esta actualmente*/
 const char *abb_iter_in_ver_actual(const abb_iter_t *iter);
 
 /*Devuelve true si el iterador esta al final*/
 bool abb_iter_in_al_final(const abb_iter_t *iter);
 
+/*Devuelve true si el iterador retrocedio antes del primer elemento*/
+bool abb_iter_in_al_principio(const abb_iter_t *iter);
+
+/*Devuelve el dato del elemento actual, o NULL si el iterador esta fuera*/
+void *abb_iter_in_ver_dato(const abb_iter_t *iter);
+
+/*Reemplaza el dato del elemento actual, destruyendo el anterior como
+abb_guardar. Pre: el iterador se creo sobre arbol*/
+bool abb_iter_in_reemplazar_dato(abb_t *arbol, abb_iter_t *iter, void *dato);
+
+/*Borra el elemento actual, devuelve su dato y deja el iterador en el
+siguiente. Los demas iteradores siguen siendo validos salvo los que
+estaban en el elemento borrado. Pre: el iterador se creo sobre arbol*/
+void *abb_iter_in_borrar_actual(abb_t *arbol, abb_iter_t *iter);
+
+/*Recorre In-Order desde el elemento actual aplicando visitar, hasta el
+final o hasta que visitar devuelva false. En ese caso el iterador queda en
+el siguiente elemento, y volver a llamarla continua el recorrido*/
+void abb_iter_in_recorrer(abb_iter_t *iter, bool visitar(const char *, void *, void *), void *extra);
+
 /*Destruye el iterador*/
 void abb_iter_in_destruir(abb_iter_t* iter);
 
+/* Cursor de busqueda: recuerda la posicion de la ultima clave buscada y
+busca la siguiente desde ahi. Conviene cuando las claves llegan casi
+ordenadas, porque cada busqueda cuesta segun la distancia a la anterior y
+no segun el tamaño del abb. Sigue siendo valido despues de borrar claves,
+pero entonces vuelve a empezar desde la raiz */
+
+typedef struct abb_cursor abb_cursor_t;
+
+/*Crea un cursor sobre el abb, que debe existir mientras se use el cursor*/
+abb_cursor_t* abb_cursor_crear(abb_t *arbol);
+
+/*Devuelve dato por clave, buscando desde la ultima posicion del cursor*/
+void* abb_cursor_obtener(abb_cursor_t *cursor, const char *clave);
+
+/*Devuelve true si la clave pertenece, buscando desde la ultima posicion*/
+bool abb_cursor_pertenece(abb_cursor_t *cursor, const char *clave);
+
+/*Guarda clave/dato como abb_guardar, buscando desde la ultima posicion*/
+bool abb_cursor_guardar(abb_cursor_t *cursor, const char *clave, void *dato);
+
+/*Destruye el cursor*/
+void abb_cursor_destruir(abb_cursor_t *cursor);
+
+/* Abb congelado: copia de solo lectura, sin punteros entre nodos, pensada
+para arboles que se arman una vez y despues solo se consultan */
+
+typedef struct abb_congelado abb_congelado_t;
+
+/*Convierte el abb en uno congelado y destruye el abb original, cuyos datos
+pasan a ser del congelado. Devuelve NULL en caso de error, dejando el abb
+intacto*/
+abb_congelado_t* abb_congelar(abb_t *arbol);
+
+/*Devuelve dato por clave*/
+void *abb_congelado_obtener(const abb_congelado_t *congelado, const char *clave);
+
+/*Devuelve true si la clave pertenece al abb congelado*/
+bool abb_congelado_pertenece(const abb_congelado_t *congelado, const char *clave);
+
+/*Devuelve la cantidad de elementos en el abb congelado*/
+size_t abb_congelado_cantidad(const abb_congelado_t *congelado);
+
+/*Devuelve los bytes que ocupa el abb congelado, claves incluidas*/
+size_t abb_congelado_memoria(const abb_congelado_t *congelado);
+
+/*Recorre el abb congelado In-Order aplicando la funcion visitar*/
+void abb_congelado_in_order(const abb_congelado_t *congelado, bool visitar(const char *, void *, void *), void *extra);
+
+/*Destruye el abb congelado y sus datos*/
+void abb_congelado_destruir(abb_congelado_t *congelado);
+
 #endif // ABB_H
@@ -0,0 +1,29 @@
+#ifndef ABB_ENTERO_H
+#define ABB_ENTERO_H
+
+#include <stdint.h>
+#include "abb_generico.h"
+
+/* *****************************************************************
+ *                 ABB CON CLAVES ENTERAS DE ANCHO FIJO
+ * *****************************************************************/
+
+/* Abbs especializados para claves enteras, generados con ABB_DEFINE. La
+ * clave se compara sin saltos y sin llamada indirecta, y el nodo (clave,
+ * dato y dos hijos) ocupa 32 bytes en plataformas de 64 bits.
+ *
+ * Los datos son void* como en abb_t, pero el abb no los destruye: el
+ * llamador los libera antes de abb_XXX_destruir si corresponde.
+ *
+ *   abb_u32_t  claves uint32_t
+ *   abb_u64_t  claves uint64_t
+ *   abb_i64_t  claves int64_t */
+
+// Devuelve -1, 0 o 1 sin saltos
+#define ABB_COMPARAR_ENTEROS(a, b) (((a) > (b)) - ((a) < (b)))
+
+ABB_DEFINE(abb_u32, uint32_t, void*, ABB_COMPARAR_ENTEROS)
+ABB_DEFINE(abb_u64, uint64_t, void*, ABB_COMPARAR_ENTEROS)
+ABB_DEFINE(abb_i64, int64_t, void*, ABB_COMPARAR_ENTEROS)
+
+#endif // ABB_ENTERO_H
@@ -0,0 +1,194 @@
+#ifndef ABB_GENERICO_H
+#define ABB_GENERICO_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+/* *****************************************************************
+ *                 ABB GENERICO POR TIPO (MACROS)
+ * *****************************************************************/
+
+/* ABB_DEFINE(nombre, tipo_clave, tipo_valor, cmp) genera un abb
+ * especializado con clave y valor guardados dentro del nodo, sin copiar
+ * claves a cadenas ni envolver los valores en void*. cmp es una funcion o
+ * macro int cmp(tipo_clave, tipo_clave) conocida al compilar, de forma que
+ * el compilador la puede inlinear en lugar de llamarla por puntero.
+ *
+ * Se generan los tipos nombre_t y nombre_nodo_t y las primitivas:
+ *
+ *   nombre_t*    nombre_crear(void);
+ *   bool         nombre_guardar(nombre_t*, tipo_clave, tipo_valor);
+ *   tipo_valor*  nombre_obtener(const nombre_t*, tipo_clave);
+ *   bool         nombre_pertenece(const nombre_t*, tipo_clave);
+ *   bool         nombre_borrar(nombre_t*, tipo_clave, tipo_valor* valor);
+ *   size_t       nombre_cantidad(const nombre_t*);
+ *   void         nombre_in_order(nombre_t*, bool visitar(tipo_clave, tipo_valor*, void*), void*);
+ *   void         nombre_destruir(nombre_t*);
+ *
+ * nombre_obtener devuelve un puntero al valor dentro del nodo (NULL si la
+ * clave no esta), valido hasta que se borre la clave. nombre_borrar copia
+ * el valor borrado en *valor si no es NULL. Como los valores viven en el
+ * nodo no hay funcion de destruccion de datos. Durante nombre_in_order el
+ * arbol tiene enlaces temporales, por lo que visitar no debe usarlo.
+ *
+ * Los hijos se guardan en un arreglo, de forma que el descenso elige el
+ * hijo con el resultado de la comparacion en lugar de con un salto. Con
+ * claves y valores de 8 bytes el nodo ocupa 32 bytes (ver abb_entero.h). */
+
+#define ABB_DEFINE(nombre, tipo_clave, tipo_valor, cmp)                         \
+                                                                                \
+typedef struct nombre##_nodo {                                                  \
+    tipo_clave clave;                                                           \
+    tipo_valor valor;                                                           \
+    struct nombre##_nodo* hijos[2];                                             \
+} nombre##_nodo_t;                                                              \
+                                                                                \
+typedef struct nombre {                                                         \
+    nombre##_nodo_t* raiz;                                                      \
+    size_t tam;                                                                 \
+} nombre##_t;                                                                   \
+                                                                                \
+static inline nombre##_t* nombre##_crear(void) {                                \
+    nombre##_t* arbol = malloc(sizeof(nombre##_t));                             \
+    if(!arbol) return NULL;                                                     \
+    arbol->raiz = NULL;                                                         \
+    arbol->tam = 0;                                                             \
+    return arbol;                                                               \
+}                                                                               \
+                                                                                \
+/* Devuelve el enlace donde esta, o deberia estar, el nodo de la clave */       \
+static inline nombre##_nodo_t** nombre##_buscar_enlace(nombre##_nodo_t** enlace, tipo_clave clave) { \
+    int comp;                                                                   \
+    while(*enlace && (comp = cmp(clave, (*enlace)->clave)) != 0)                \
+        enlace = &(*enlace)->hijos[comp > 0];                                   \
+    return enlace;                                                              \
+}                                                                               \
+                                                                                \
+static inline bool nombre##_guardar(nombre##_t* arbol, tipo_clave clave, tipo_valor valor) { \
+    if(!arbol) return false;                                                    \
+    nombre##_nodo_t** enlace = nombre##_buscar_enlace(&arbol->raiz, clave);     \
+    if(*enlace)                                                                 \
+    {                                                                           \
+        (*enlace)->valor = valor;                                               \
+        return true;                                                            \
+    }                                                                           \
+    nombre##_nodo_t* nodo = malloc(sizeof(nombre##_nodo_t));                    \
+    if(!nodo) return false;                                                     \
+    nodo->clave = clave;                                                        \
+    nodo->valor = valor;                                                        \
+    nodo->hijos[0] = NULL;                                                      \
+    nodo->hijos[1] = NULL;                                                      \
+    *enlace = nodo;                                                             \
+    arbol->tam++;                                                               \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+/* Desciende siempre hasta una hoja recordando el ultimo nodo con clave      \
+mayor o igual: el camino no depende de si la clave esta, y el compilador     \
+puede resolver cada nivel con movimientos condicionales en lugar de saltos */ \
+static inline tipo_valor* nombre##_obtener(const nombre##_t* arbol, tipo_clave clave) { \
+    if(!arbol) return NULL;                                                     \
+    nombre##_nodo_t* nodo = arbol->raiz;                                        \
+    nombre##_nodo_t* candidato = NULL;                                          \
+    while(nodo)                                                                 \
+    {                                                                           \
+        int comp = cmp(clave, nodo->clave);                                     \
+        candidato = comp <= 0 ? nodo : candidato;                               \
+        nodo = nodo->hijos[comp > 0];                                           \
+    }                                                                           \
+    if(!candidato || cmp(clave, candidato->clave) != 0) return NULL;            \
+    return &candidato->valor;                                                   \
+}                                                                               \
+                                                                                \
+static inline bool nombre##_pertenece(const nombre##_t* arbol, tipo_clave clave) { \
+    return nombre##_obtener(arbol, clave) != NULL;                              \
+}                                                                               \
+                                                                                \
+static inline bool nombre##_borrar(nombre##_t* arbol, tipo_clave clave, tipo_valor* valor) { \
+    if(!arbol) return false;                                                    \
+    nombre##_nodo_t** enlace = nombre##_buscar_enlace(&arbol->raiz, clave);     \
+    nombre##_nodo_t* nodo = *enlace;                                            \
+    if(!nodo) return false;                                                     \
+    if(!nodo->hijos[0] || !nodo->hijos[1])                                      \
+    {                                                                           \
+        *enlace = nodo->hijos[!nodo->hijos[0]];                                 \
+    }                                                                           \
+    else                                                                        \
+    {                                                                           \
+        /* Se sube el mayor por izquierda al lugar del nodo */                  \
+        nombre##_nodo_t** enlace_mayor = &nodo->hijos[0];                       \
+        while((*enlace_mayor)->hijos[1])                                        \
+            enlace_mayor = &(*enlace_mayor)->hijos[1];                          \
+        nombre##_nodo_t* mayor = *enlace_mayor;                                 \
+        *enlace_mayor = mayor->hijos[0];                                        \
+        mayor->hijos[0] = nodo->hijos[0];                                       \
+        mayor->hijos[1] = nodo->hijos[1];                                       \
+        *enlace = mayor;                                                        \
+    }                                                                           \
+    if(valor)                                                                   \
+        *valor = nodo->valor;                                                   \
+    free(nodo);                                                                 \
+    arbol->tam--;                                                               \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+static inline size_t nombre##_cantidad(const nombre##_t* arbol) {               \
+    return arbol->tam;                                                          \
+}                                                                               \
+                                                                                \
+/* Recorre sin recursion aunque el arbol este degenerado (Morris): enlaza       \
+el mayor de cada subarbol izquierdo con su sucesor para poder volver. Si        \
+visitar corta, sigue sin visitar ni enlazar hasta deshacer los enlaces */       \
+static inline void nombre##_in_order(nombre##_t* arbol, bool visitar(tipo_clave, tipo_valor*, void*), void* extra) { \
+    if(!arbol) return;                                                          \
+    nombre##_nodo_t* nodo = arbol->raiz;                                        \
+    size_t enlazados = 0;                                                       \
+    bool seguir = true;                                                         \
+    while(nodo && (seguir || enlazados))                                        \
+    {                                                                           \
+        nombre##_nodo_t* anterior = nodo->hijos[0];                             \
+        while(anterior && anterior->hijos[1] && anterior->hijos[1] != nodo)     \
+            anterior = anterior->hijos[1];                                      \
+        if(anterior && !anterior->hijos[1] && seguir)                           \
+        {                                                                       \
+            anterior->hijos[1] = nodo;                                          \
+            enlazados++;                                                        \
+            nodo = nodo->hijos[0];                                              \
+            continue;                                                           \
+        }                                                                       \
+        if(anterior && anterior->hijos[1] == nodo)                              \
+        {                                                                       \
+            anterior->hijos[1] = NULL;                                          \
+            enlazados--;                                                        \
+        }                                                                       \
+        if(seguir)                                                              \
+            seguir = visitar(nodo->clave, &nodo->valor, extra);                 \
+        nodo = nodo->hijos[1];                                                  \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+/* Libera rotando a derecha hasta que el nodo no tenga hijo izquierdo, sin    \
+recursion aunque el arbol este degenerado */                                    \
+static inline void nombre##_destruir(nombre##_t* arbol) {                       \
+    if(!arbol) return;                                                          \
+    nombre##_nodo_t* nodo = arbol->raiz;                                        \
+    while(nodo)                                                                 \
+    {                                                                           \
+        nombre##_nodo_t* siguiente;                                             \
+        if(nodo->hijos[0])                                                      \
+        {                                                                       \
+            siguiente = nodo->hijos[0];                                         \
+            nodo->hijos[0] = siguiente->hijos[1];                               \
+            siguiente->hijos[1] = nodo;                                         \
+        }                                                                       \
+        else                                                                    \
+        {                                                                       \
+            siguiente = nodo->hijos[1];                                         \
+            free(nodo);                                                         \
+        }                                                                       \
+        nodo = siguiente;                                                       \
+    }                                                                           \
+    free(arbol);                                                                \
+}
+
+#endif // ABB_GENERICO_H
@@ -0,0 +1,410 @@
+#define _POSIX_C_SOURCE 200809L
+#include "abb_particionado.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define REBALANCEO_MINIMO 1024  // Particiones mas chicas nunca se rebalancean
+#define FACTOR_DESBALANCE 2     // Se tolera 1/FACTOR_DESBALANCE del promedio de mas
+#define LARGO_LINEA_CACHE 64
+
+/* Cada particion ocupa su propia linea de cache, para que los hilos que
+ * toman locks de particiones distintas no se invaliden entre si. */
+typedef struct particion {
+    abb_t* arbol;
+    pthread_mutex_t mutex;
+    char relleno[LARGO_LINEA_CACHE];
+} particion_t;
+
+/* Los limites no cambian una vez publicados: al rebalancear se publica uno
+ * nuevo y el viejo pasa a la lista de retirados, porque algun hilo puede
+ * estar comparando contra el. Se liberan al destruir. */
+typedef struct limite {
+    struct limite* retirado_siguiente;
+    char clave[];
+} limite_t;
+
+/* Los limites y los abbs de las particiones solo cambian al rebalancear.
+ * El rebalanceo toma estructura, deja secuencia impar, toma el lock de
+ * todas las particiones, hace los cambios y deja secuencia par de nuevo.
+ *
+ * Las demas primitivas buscan la particion leyendo secuencia antes, sin
+ * escribir nada compartido, toman solo el lock de esa particion y verifican
+ * que secuencia no haya cambiado; si cambio, sueltan el lock y buscan de
+ * nuevo. Con el lock tomado ningun rebalanceo puede empezar a cambiar nada
+ * hasta que lo suelten. */
+struct abb_particionado {
+    abb_comparar_clave_t comparar;
+    abb_destruir_dato_t destruir;
+    limite_t** limites;         // cantidad - 1 limites
+    limite_t* retirados;
+    particion_t* particiones;
+    size_t cantidad;            // Cantidad de particiones
+    size_t umbral;              // Tamaño a partir del cual se rebalancea
+    size_t secuencia;           // Impar mientras se rebalancea
+    pthread_mutex_t estructura; // Rebalanceos y recorridos de todo
+};
+
+/* *****************************************************************
+ *                    FUNCIONES AUXILIARES
+ * *****************************************************************/
+
+// Devuelve un limite nuevo con una copia de la clave, o NULL si no hay
+// memoria.
+static limite_t* copiar_limite(const char *clave)
+{
+    limite_t* copia = malloc(sizeof(limite_t) + strlen(clave) + 1);
+    if(copia) {
+        copia->retirado_siguiente = NULL;
+        strcpy(copia->clave, clave);
+    }
+    return copia;
+}
+
+// Devuelve la particion de la clave: la primera cuyo limite es mayor.
+// Puede correr a la par de un rebalanceo, asi que el resultado solo vale
+// si secuencia no cambio mientras tanto.
+static particion_t* buscar_particion(const abb_particionado_t *particionado, const char *clave)
+{
+    size_t desde = 0, hasta = particionado->cantidad - 1;
+    while(desde < hasta) {
+        size_t medio = desde + (hasta - desde) / 2;
+        const limite_t* limite = __atomic_load_n(&particionado->limites[medio], __ATOMIC_ACQUIRE);
+        if(particionado->comparar(clave, limite->clave) < 0)
+            hasta = medio;
+        else
+            desde = medio + 1;
+    }
+    return &particionado->particiones[desde];
+}
+
+// Devuelve la particion de la clave con su lock tomado.
+static particion_t* tomar_particion(abb_particionado_t *particionado, const char *clave)
+{
+    while(true) {
+        size_t secuencia = __atomic_load_n(&particionado->secuencia, __ATOMIC_ACQUIRE);
+        if(secuencia % 2 == 1) {
+            sched_yield();
+            continue;
+        }
+        particion_t* particion = buscar_particion(particionado, clave);
+        pthread_mutex_lock(&particion->mutex);
+        if(__atomic_load_n(&particionado->secuencia, __ATOMIC_ACQUIRE) == secuencia)
+            return particion;
+        pthread_mutex_unlock(&particion->mutex);
+    }
+}
+
+// Toma el lock de todas las particiones, en orden.
+static void tomar_todas(abb_particionado_t *particionado)
+{
+    for(size_t i = 0; i < particionado->cantidad; i++)
+        pthread_mutex_lock(&particionado->particiones[i].mutex);
+}
+
+static void soltar_todas(abb_particionado_t *particionado)
+{
+    for(size_t i = 0; i < particionado->cantidad; i++)
+        pthread_mutex_unlock(&particionado->particiones[i].mutex);
+}
+
+// Devuelve la clave de la posicion del medio del abb, o NULL si tiene menos
+// de dos claves.
+static const char* buscar_mediana(abb_t *arbol)
+{
+    size_t mitad = abb_cantidad(arbol) / 2;
+    if(mitad == 0)
+        return NULL;
+    abb_iter_t* iter = abb_iter_in_crear(arbol);
+    if(iter == NULL)
+        return NULL;
+    for(size_t i = 0; i < mitad; i++)
+        abb_iter_in_avanzar(iter);
+    const char* mediana = abb_iter_in_ver_actual(iter);
+    abb_iter_in_destruir(iter);
+    return mediana;
+}
+
+// Pasa las claves desde la mediana de la particion i en adelante a la
+// particion i + 1, o las anteriores a la mediana a la particion i - 1, y
+// mueve el limite entre ambas a la mediana. Devuelve false si no pudo.
+// Pre: estructura y todas las particiones estan tomadas.
+static bool partir_particion(abb_particionado_t *particionado, size_t i, bool hacia_la_derecha)
+{
+    abb_t* arbol = particionado->particiones[i].arbol;
+    const char* mediana = buscar_mediana(arbol);
+    if(mediana == NULL)
+        return false;
+    limite_t* limite = copiar_limite(mediana);
+    if(limite == NULL)
+        return false;
+
+    abb_t* mayores = abb_partir(arbol, limite->clave);
+    if(mayores == NULL) {
+        free(limite);
+        return false;
+    }
+
+    // abb_juntar deja todo en el abb de las claves menores, que pasa a ser
+    // el de la particion; el otro queda vacio
+    size_t limite_movido = hacia_la_derecha ? i : i - 1;
+    if(hacia_la_derecha) {
+        abb_t* vecino = particionado->particiones[i + 1].arbol;
+        abb_juntar(mayores, vecino);
+        particionado->particiones[i + 1].arbol = mayores;
+        abb_destruir(vecino);
+    } else {
+        abb_juntar(particionado->particiones[i - 1].arbol, arbol);
+        particionado->particiones[i].arbol = mayores;
+        abb_destruir(arbol);
+    }
+    limite_t* viejo = particionado->limites[limite_movido];
+    viejo->retirado_siguiente = particionado->retirados;
+    particionado->retirados = viejo;
+    __atomic_store_n(&particionado->limites[limite_movido], limite, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Recalcula el tamaño a partir del cual una particion se rebalancea: el
+// promedio mas una holgura, que una particion si puede superar aun con solo
+// dos particiones. Si la mas grande ya lo supera (porque no se pudo partir)
+// el umbral queda por encima de ella, para que guardar no vuelva a
+// rebalancear enseguida sin mover nada.
+// Pre: estructura y todas las particiones estan tomadas.
+static void actualizar_umbral(abb_particionado_t *particionado, size_t total, size_t mayor)
+{
+    size_t promedio = total / particionado->cantidad;
+    size_t umbral = promedio + promedio / FACTOR_DESBALANCE + REBALANCEO_MINIMO;
+    if(mayor >= umbral)
+        umbral = mayor + REBALANCEO_MINIMO;
+    particionado->umbral = umbral;
+}
+
+// Devuelve la posicion de la particion con mas claves.
+// Pre: estructura y todas las particiones estan tomadas.
+static size_t particion_mayor(const abb_particionado_t *particionado)
+{
+    size_t mayor = 0;
+    for(size_t i = 1; i < particionado->cantidad; i++)
+        if(abb_cantidad(particionado->particiones[i].arbol) > abb_cantidad(particionado->particiones[mayor].arbol))
+            mayor = i;
+    return mayor;
+}
+
+/* *****************************************************************
+ *                PRIMITIVAS DEL ABB PARTICIONADO
+ * *****************************************************************/
+
+// Crea un abb particionado con cantidad_limites + 1 particiones.
+// Pre: limites esta ordenado de menor a mayor segun cmp y no tiene
+// repetidos. Los limites se copian.
+// Post: devuelve un abb particionado vacío, o NULL en caso de error.
+abb_particionado_t* abb_particionado_crear(abb_comparar_clave_t cmp, abb_destruir_dato_t destruir_dato, const char *limites[], size_t cantidad_limites)
+{
+    abb_particionado_t* particionado = malloc(sizeof(abb_particionado_t));
+    if(particionado == NULL)
+        return NULL;
+
+    particionado->comparar = cmp;
+    particionado->destruir = destruir_dato;
+    particionado->cantidad = cantidad_limites + 1;
+    particionado->umbral = REBALANCEO_MINIMO;
+    particionado->secuencia = 0;
+    particionado->retirados = NULL;
+    particionado->limites = calloc(cantidad_limites + 1, sizeof(limite_t*));
+    particionado->particiones = calloc(particionado->cantidad, sizeof(particion_t));
+    if(particionado->limites == NULL || particionado->particiones == NULL) {
+        free(particionado->limites);
+        free(particionado->particiones);
+        free(particionado);
+        return NULL;
+    }
+    pthread_mutex_init(&particionado->estructura, NULL);
+
+    bool ok = true;
+    for(size_t i = 0; i < cantidad_limites && ok; i++)
+        ok = (particionado->limites[i] = copiar_limite(limites[i])) != NULL;
+    for(size_t i = 0; i < particionado->cantidad; i++) {
+        pthread_mutex_init(&particionado->particiones[i].mutex, NULL);
+        if(ok)
+            ok = (particionado->particiones[i].arbol = abb_crear(cmp, destruir_dato)) != NULL;
+    }
+    if(!ok) {
+        abb_particionado_destruir(particionado);
+        return NULL;
+    }
+    return particionado;
+}
+
+// Destruye el abb particionado y sus datos.
+// Pre: el abb particionado fue creado y ningun otro hilo lo usa.
+void abb_particionado_destruir(abb_particionado_t *particionado)
+{
+    for(size_t i = 0; i < particionado->cantidad; i++) {
+        if(particionado->particiones[i].arbol)
+            abb_destruir(particionado->particiones[i].arbol);
+        pthread_mutex_destroy(&particionado->particiones[i].mutex);
+        free(particionado->limites[i]);
+    }
+    while(particionado->retirados) {
+        limite_t* siguiente = particionado->retirados->retirado_siguiente;
+        free(particionado->retirados);
+        particionado->retirados = siguiente;
+    }
+    pthread_mutex_destroy(&particionado->estructura);
+    free(particionado->particiones);
+    free(particionado->limites);
+    free(particionado);
+}
+
+// Guarda clave/dato en la particion que le corresponde. Si la particion
+// quedo demasiado grande la rebalancea.
+// Pre: el abb particionado fue creado.
+bool abb_particionado_guardar(abb_particionado_t *particionado, const char *clave, void *dato)
+{
+    particion_t* particion = tomar_particion(particionado, clave);
+    bool guardado = abb_guardar(particion->arbol, clave, dato);
+    bool desbalanceada = abb_cantidad(particion->arbol) > particionado->umbral;
+    pthread_mutex_unlock(&particion->mutex);
+
+    if(desbalanceada && particionado->cantidad > 1)
+        abb_particionado_rebalancear(particionado);
+    return guardado;
+}
+
+// Devuelve el dato de la clave, o NULL si no esta. El dato sigue siendo
+// valido solo mientras ningun otro hilo borre o reemplace la clave.
+// Pre: el abb particionado fue creado.
+void* abb_particionado_obtener(abb_particionado_t *particionado, const char *clave)
+{
+    // Aun las consultas modifican el abb si tiene cache, asi que tambien
+    // toman el lock de la particion
+    particion_t* particion = tomar_particion(particionado, clave);
+    void* dato = abb_obtener(particion->arbol, clave);
+    pthread_mutex_unlock(&particion->mutex);
+    return dato;
+}
+
+// Devuelve true si la clave esta.
+// Pre: el abb particionado fue creado.
+bool abb_particionado_pertenece(abb_particionado_t *particionado, const char *clave)
+{
+    particion_t* particion = tomar_particion(particionado, clave);
+    bool pertenece = abb_pertenece(particion->arbol, clave);
+    pthread_mutex_unlock(&particion->mutex);
+    return pertenece;
+}
+
+// Borra la clave y devuelve su dato, o NULL si no estaba.
+// Pre: el abb particionado fue creado.
+void* abb_particionado_borrar(abb_particionado_t *particionado, const char *clave)
+{
+    particion_t* particion = tomar_particion(particionado, clave);
+    void* dato = abb_borrar(particion->arbol, clave);
+    pthread_mutex_unlock(&particion->mutex);
+    return dato;
+}
+
+// Devuelve la cantidad de claves guardadas en todas las particiones.
+// Pre: el abb particionado fue creado.
+size_t abb_particionado_cantidad(abb_particionado_t *particionado)
+{
+    size_t cantidad = 0;
+    pthread_mutex_lock(&particionado->estructura);
+    for(size_t i = 0; i < particionado->cantidad; i++) {
+        pthread_mutex_lock(&particionado->particiones[i].mutex);
+        cantidad += abb_cantidad(particionado->particiones[i].arbol);
+        pthread_mutex_unlock(&particionado->particiones[i].mutex);
+    }
+    pthread_mutex_unlock(&particionado->estructura);
+    return cantidad;
+}
+
+// Devuelve la cantidad de claves de la particion i.
+// Pre: el abb particionado fue creado e i es menor a la cantidad de
+// particiones.
+size_t abb_particionado_cantidad_particion(abb_particionado_t *particionado, size_t i)
+{
+    pthread_mutex_lock(&particionado->estructura);
+    pthread_mutex_lock(&particionado->particiones[i].mutex);
+    size_t cantidad = abb_cantidad(particionado->particiones[i].arbol);
+    pthread_mutex_unlock(&particionado->particiones[i].mutex);
+    pthread_mutex_unlock(&particionado->estructura);
+    return cantidad;
+}
+
+// Devuelve la cantidad de particiones.
+// Pre: el abb particionado fue creado.
+size_t abb_particionado_particiones(const abb_particionado_t *particionado)
+{
+    return particionado->cantidad;
+}
+
+typedef struct recorrido {
+    bool (*visitar)(const char *, void *, void *);
+    void* extra;
+    bool seguir;
+} recorrido_t;
+
+static bool visitar_particion(const char *clave, void *dato, void *extra)
+{
+    recorrido_t* recorrido = extra;
+    recorrido->seguir = recorrido->visitar(clave, dato, recorrido->extra);
+    return recorrido->seguir;
+}
+
+// Recorre todas las claves en orden, una particion detras de otra, hasta
+// que visitar devuelva false.
+// Pre: el abb particionado fue creado.
+void abb_particionado_in_order(abb_particionado_t *particionado, bool visitar(const char *, void *, void *), void *extra)
+{
+    recorrido_t recorrido = {visitar, extra, true};
+    pthread_mutex_lock(&particionado->estructura);
+    for(size_t i = 0; i < particionado->cantidad && recorrido.seguir; i++) {
+        pthread_mutex_lock(&particionado->particiones[i].mutex);
+        abb_in_order(particionado->particiones[i].arbol, visitar_particion, &recorrido);
+        pthread_mutex_unlock(&particionado->particiones[i].mutex);
+    }
+    pthread_mutex_unlock(&particionado->estructura);
+}
+
+// Pasa la mitad de las claves de la particion mas grande a su vecina mas
+// chica, mientras alguna supere el umbral, y recalcula el umbral. Devuelve
+// cuantos limites se movieron.
+// Pre: el abb particionado fue creado.
+size_t abb_particionado_rebalancear(abb_particionado_t *particionado)
+{
+    // Con secuencia impar nadie vuelve a entrar a una particion, y al tomar
+    // todos los locks se espera a los que ya estaban adentro
+    pthread_mutex_lock(&particionado->estructura);
+    __atomic_add_fetch(&particionado->secuencia, 1, __ATOMIC_SEQ_CST);
+    tomar_todas(particionado);
+    size_t total = 0;
+    for(size_t i = 0; i < particionado->cantidad; i++)
+        total += abb_cantidad(particionado->particiones[i].arbol);
+
+    // Se parte contra el umbral que vio guardar, asi el rebalanceo que
+    // dispara siempre mueve algo. Cada paso achica la particion mas grande;
+    // se corta a las cantidad vueltas para no pasar claves de un lado a
+    // otro indefinidamente
+    size_t movidos = 0;
+    for(size_t vuelta = 0; vuelta < particionado->cantidad && particionado->cantidad > 1; vuelta++) {
+        size_t mayor = particion_mayor(particionado);
+        if(abb_cantidad(particionado->particiones[mayor].arbol) <= particionado->umbral)
+            break;
+
+        bool hacia_la_derecha = mayor == 0;
+        if(mayor > 0 && mayor + 1 < particionado->cantidad)
+            hacia_la_derecha = abb_cantidad(particionado->particiones[mayor + 1].arbol) < abb_cantidad(particionado->particiones[mayor - 1].arbol);
+        if(!partir_particion(particionado, mayor, hacia_la_derecha))
+            break;
+        movidos++;
+    }
+    actualizar_umbral(particionado, total, abb_cantidad(particionado->particiones[particion_mayor(particionado)].arbol));
+    __atomic_add_fetch(&particionado->secuencia, 1, __ATOMIC_RELEASE);
+    soltar_todas(particionado);
+    pthread_mutex_unlock(&particionado->estructura);
+    return movidos;
+}
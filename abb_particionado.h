@@ -0,0 +1,86 @@
+#ifndef _ABB_PARTICIONADO_H
+#define _ABB_PARTICIONADO_H
+
+#include "abb.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/* *****************************************************************
+ *                DEFINICION DE LOS TIPOS DE DATOS
+ * *****************************************************************/
+
+/* Diccionario ordenado para varios hilos. El espacio de claves se parte en
+ * rangos consecutivos, cada uno guardado en su propio abb con su propio
+ * lock, asi que escrituras sobre rangos distintos no se esperan entre si.
+ * Encontrar la particion de una clave no escribe memoria compartida: solo
+ * se toma el lock de la particion encontrada.
+ *
+ * La particion i guarda las claves k con limites[i-1] <= k < limites[i].
+ * Cuando una particion supera el promedio en mas de la mitad (y en mas de
+ * unas mil claves), la mitad de sus claves pasa a la particion vecina mas
+ * chica y se corre el limite.  */
+
+struct abb_particionado;  // Definición completa en abb_particionado.c.
+typedef struct abb_particionado abb_particionado_t;
+
+
+/* *****************************************************************
+ *                PRIMITIVAS DEL ABB PARTICIONADO
+ * *****************************************************************/
+
+// Crea un abb particionado con cantidad_limites + 1 particiones.
+// Pre: limites esta ordenado de menor a mayor segun cmp y no tiene
+// repetidos. Los limites se copian.
+// Post: devuelve un abb particionado vacío, o NULL en caso de error.
+abb_particionado_t* abb_particionado_crear(abb_comparar_clave_t cmp, abb_destruir_dato_t destruir_dato, const char *limites[], size_t cantidad_limites);
+
+// Destruye el abb particionado y sus datos.
+// Pre: el abb particionado fue creado y ningun otro hilo lo usa.
+void abb_particionado_destruir(abb_particionado_t *particionado);
+
+// Guarda clave/dato en la particion que le corresponde. Si la particion
+// quedo demasiado grande la rebalancea.
+// Pre: el abb particionado fue creado.
+bool abb_particionado_guardar(abb_particionado_t *particionado, const char *clave, void *dato);
+
+// Devuelve el dato de la clave, o NULL si no esta. El dato sigue siendo
+// valido solo mientras ningun otro hilo borre o reemplace la clave.
+// Pre: el abb particionado fue creado.
+void* abb_particionado_obtener(abb_particionado_t *particionado, const char *clave);
+
+// Devuelve true si la clave esta.
+// Pre: el abb particionado fue creado.
+bool abb_particionado_pertenece(abb_particionado_t *particionado, const char *clave);
+
+// Borra la clave y devuelve su dato, o NULL si no estaba.
+// Pre: el abb particionado fue creado.
+void* abb_particionado_borrar(abb_particionado_t *particionado, const char *clave);
+
+// Devuelve la cantidad de claves guardadas en todas las particiones.
+// Pre: el abb particionado fue creado.
+size_t abb_particionado_cantidad(abb_particionado_t *particionado);
+
+// Devuelve la cantidad de claves de la particion i.
+// Pre: el abb particionado fue creado e i es menor a la cantidad de
+// particiones.
+size_t abb_particionado_cantidad_particion(abb_particionado_t *particionado, size_t i);
+
+// Devuelve la cantidad de particiones.
+// Pre: el abb particionado fue creado.
+size_t abb_particionado_particiones(const abb_particionado_t *particionado);
+
+// Recorre todas las claves en orden, una particion detras de otra, hasta
+// que visitar devuelva false. Cada particion queda bloqueada mientras se la
+// recorre, asi que visitar no debe usar el abb particionado.
+// Pre: el abb particionado fue creado.
+void abb_particionado_in_order(abb_particionado_t *particionado, bool visitar(const char *, void *, void *), void *extra);
+
+// Pasa la mitad de las claves de la particion mas grande a su vecina mas
+// chica, mientras alguna supere el umbral calculado en el rebalanceo
+// anterior: el promedio de entonces mas la mitad, mas unas mil claves.
+// Devuelve cuantos limites se movieron.
+// Pre: el abb particionado fue creado.
+size_t abb_particionado_rebalancear(abb_particionado_t *particionado);
+
+#endif // _ABB_PARTICIONADO_H
@@ -0,0 +1,534 @@
+#define _POSIX_C_SOURCE 200809L
+#include "abb.h"
+#include "abb_particionado.h"
+#include "abb_entero.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <pthread.h>
+
+/* ******************************************************************
+ *                 MEDICIONES DE RENDIMIENTO DEL ABB
+ * *****************************************************************/
+
+/* Se compila aparte con 'make benchmark'. Recibe opcionalmente la cantidad
+ * de claves: ./benchmark [cantidad] */
+
+#define LARGO_CLAVE 17
+#define ENTRADAS_CACHE 4096
+#define HILOS 4
+
+static double segundos_desde(clock_t inicio)
+{
+    return (double) (clock() - inicio) / CLOCKS_PER_SEC;
+}
+
+/* clock() suma el tiempo de todos los hilos; con varios se mide el real */
+static double segundos_reales_desde(const struct timespec* inicio)
+{
+    struct timespec fin;
+    clock_gettime(CLOCK_MONOTONIC, &fin);
+    return (double) (fin.tv_sec - inicio->tv_sec) + (double) (fin.tv_nsec - inicio->tv_nsec) / 1e9;
+}
+
+static void imprimir_medicion(const char* nombre, double segundos, size_t operaciones)
+{
+    printf("%-40s %10.1f ns/op\n", nombre, segundos * 1e9 / (double) operaciones);
+}
+
+static uint64_t numero_aleatorio(void)
+{
+    return ((uint64_t) rand() << 33) ^ ((uint64_t) rand() << 11) ^ (uint64_t) rand();
+}
+
+/* Claves enteras aleatorias y sus equivalentes como cadena */
+static uint64_t* crear_claves(size_t cantidad, char (**cadenas)[LARGO_CLAVE])
+{
+    uint64_t* claves = malloc(cantidad * sizeof(uint64_t));
+    *cadenas = malloc(cantidad * LARGO_CLAVE);
+    for (size_t i = 0; i < cantidad; i++) {
+        claves[i] = numero_aleatorio();
+        sprintf((*cadenas)[i], "%016llx", (unsigned long long) claves[i]);
+    }
+    return claves;
+}
+
+static void medir_claves_enteras(size_t cantidad)
+{
+    char (*cadenas)[LARGO_CLAVE];
+    uint64_t* claves = crear_claves(cantidad, &cadenas);
+    size_t encontrados = 0;
+
+    printf("-- Claves de cadena (abb_t) contra enteras (abb_u64_t), %zu claves\n", cantidad);
+
+    abb_t* abb = abb_crear(strcmp, NULL);
+    clock_t inicio = clock();
+    for (size_t i = 0; i < cantidad; i++)
+        abb_guardar(abb, cadenas[i], NULL);
+    imprimir_medicion("abb_guardar (cadena)", segundos_desde(inicio), cantidad);
+
+    inicio = clock();
+    for (size_t i = 0; i < cantidad; i++)
+        encontrados += abb_pertenece(abb, cadenas[i]);
+    imprimir_medicion("abb_pertenece (cadena)", segundos_desde(inicio), cantidad);
+
+    abb_u64_t* enteros = abb_u64_crear();
+    inicio = clock();
+    for (size_t i = 0; i < cantidad; i++)
+        abb_u64_guardar(enteros, claves[i], NULL);
+    imprimir_medicion("abb_u64_guardar", segundos_desde(inicio), cantidad);
+
+    inicio = clock();
+    for (size_t i = 0; i < cantidad; i++)
+        encontrados += abb_u64_pertenece(enteros, claves[i]);
+    imprimir_medicion("abb_u64_pertenece", segundos_desde(inicio), cantidad);
+
+    if (encontrados != 2 * cantidad)
+        printf("ERROR: se encontraron %zu de %zu claves\n", encontrados, 2 * cantidad);
+
+    abb_destruir(abb);
+    abb_u64_destruir(enteros);
+    free(claves);
+    free(cadenas);
+}
+
+static void medir_congelado(size_t cantidad)
+{
+    char (*cadenas)[LARGO_CLAVE];
+    uint64_t* claves = crear_claves(cantidad, &cadenas);
+    size_t encontrados = 0;
+
+    printf("-- abb_t contra abb congelado, %zu claves\n", cantidad);
+
+    abb_t* abb = abb_crear(strcmp, NULL);
+    for (size_t i = 0; i < cantidad; i++)
+        abb_guardar(abb, cadenas[i], NULL);
+
+    clock_t inicio = clock();
+    for (size_t i = 0; i < cantidad; i++)
+        encontrados += abb_pertenece(abb, cadenas[i]);
+    imprimir_medicion("abb_pertenece", segundos_desde(inicio), cantidad);
+
+    // Nodos y claves, cada uno en su propio malloc
+    size_t memoria_abb = abb_memoria(abb);
+
+    abb_congelado_t* congelado = abb_congelar(abb);
+    inicio = clock();
+    for (size_t i = 0; i < cantidad; i++)
+        encontrados += abb_congelado_pertenece(congelado, cadenas[i]);
+    imprimir_medicion("abb_congelado_pertenece", segundos_desde(inicio), cantidad);
+
+    printf("%-40s %10zu bytes (sin contar el encabezado de cada malloc)\n", "memoria abb_t", memoria_abb);
+    printf("%-40s %10zu bytes\n", "memoria abb congelado", abb_congelado_memoria(congelado));
+
+    if (encontrados != 2 * cantidad)
+        printf("ERROR: se encontraron %zu de %zu claves\n", encontrados, 2 * cantidad);
+
+    abb_congelado_destruir(congelado);
+    free(claves);
+    free(cadenas);
+}
+
+static void medir_lote(size_t cantidad)
+{
+    char (*cadenas)[LARGO_CLAVE];
+    uint64_t* claves = crear_claves(cantidad, &cadenas);
+    const char** lote = malloc(cantidad * sizeof(char*));
+    void** datos = calloc(cantidad, sizeof(void*));
+    for (size_t i = 0; i < cantidad; i++)
+        lote[i] = cadenas[i];
+
+    printf("-- abb_guardar en ciclo contra abb_guardar_lote, %zu claves\n", cantidad);
+
+    abb_t* abb = abb_crear(strcmp, NULL);
+    clock_t inicio = clock();
+    for (size_t i = 0; i < cantidad; i++)
+        abb_guardar(abb, lote[i], NULL);
+    imprimir_medicion("abb_guardar en ciclo", segundos_desde(inicio), cantidad);
+    inicio = clock();
+    for (size_t i = 0; i < cantidad; i++)
+        abb_borrar(abb, lote[i]);
+    imprimir_medicion("abb_borrar en ciclo", segundos_desde(inicio), cantidad);
+    abb_destruir(abb);
+
+    abb = abb_crear(strcmp, NULL);
+    inicio = clock();
+    abb_guardar_lote(abb, lote, datos, cantidad, NULL);
+    imprimir_medicion("abb_guardar_lote", segundos_desde(inicio), cantidad);
+    inicio = clock();
+    abb_borrar_lote(abb, lote, cantidad, NULL);
+    imprimir_medicion("abb_borrar_lote", segundos_desde(inicio), cantidad);
+    abb_destruir(abb);
+
+    free(lote);
+    free(datos);
+    free(claves);
+    free(cadenas);
+}
+
+static void medir_filtro(size_t cantidad)
+{
+    char (*cadenas)[LARGO_CLAVE];
+    uint64_t* claves = crear_claves(2 * cantidad, &cadenas);
+    size_t encontrados = 0;
+
+    // La primera mitad se guarda; la segunda son consultas de claves ausentes
+    printf("-- Consultas de claves ausentes con y sin filtro, %zu claves\n", cantidad);
+
+    abb_t* abb = abb_crear(strcmp, NULL);
+    for (size_t i = 0; i < cantidad; i++)
+        abb_guardar(abb, cadenas[i], NULL);
+
+    clock_t inicio = clock();
+    for (size_t i = cantidad; i < 2 * cantidad; i++)
+        encontrados += abb_pertenece(abb, cadenas[i]);
+    imprimir_medicion("abb_pertenece ausentes sin filtro", segundos_desde(inicio), cantidad);
+
+    abb_filtro_activar(abb, cantidad, 0.01);
+    inicio = clock();
+    for (size_t i = cantidad; i < 2 * cantidad; i++)
+        encontrados += abb_pertenece(abb, cadenas[i]);
+    imprimir_medicion("abb_pertenece ausentes con filtro", segundos_desde(inicio), cantidad);
+
+    abb_filtro_estadisticas_t estadisticas;
+    abb_filtro_estadisticas(abb, &estadisticas);
+    printf("%-40s %10zu bytes, %zu hashes, tasa %.4f\n", "filtro", estadisticas.memoria,
+           estadisticas.funciones_hash, estadisticas.tasa_falsos_positivos);
+
+    if (encontrados != 0)
+        printf("ERROR: se encontraron %zu claves ausentes\n", encontrados);
+
+    abb_destruir(abb);
+    free(claves);
+    free(cadenas);
+}
+
+/* Traza de consultas con distribucion de Zipf (s = 1): la clave de rango r
+se consulta con probabilidad proporcional a 1/r */
+static size_t* crear_traza_zipf(size_t claves, size_t consultas)
+{
+    double* acumulada = malloc(claves * sizeof(double));
+    double total = 0;
+    for (size_t r = 0; r < claves; r++) {
+        total += 1.0 / (double) (r + 1);
+        acumulada[r] = total;
+    }
+
+    size_t* traza = malloc(consultas * sizeof(size_t));
+    for (size_t i = 0; i < consultas; i++) {
+        double objetivo = total * (double) rand() / RAND_MAX;
+        size_t inicio = 0, fin = claves - 1;
+        while (inicio < fin) {
+            size_t medio = (inicio + fin) / 2;
+            if (acumulada[medio] < objetivo)
+                inicio = medio + 1;
+            else
+                fin = medio;
+        }
+        traza[i] = inicio;
+    }
+    free(acumulada);
+    return traza;
+}
+
+/* Mide la traza completa y, aparte, solo las consultas a las claves mas
+frecuentes, que son las que la cache puede resolver */
+static void medir_traza(abb_t* abb, char (*cadenas)[LARGO_CLAVE], size_t* traza, size_t consultas, const char* nombre)
+{
+    // Una pasada sin medir, para comparar con la cache ya llena y con los
+    // nodos frecuentes ya en la cache del procesador en ambos casos
+    size_t encontrados = 0, frecuentes = 0;
+    for (size_t i = 0; i < consultas; i++)
+        frecuentes += abb_pertenece(abb, cadenas[traza[i]]);
+    frecuentes = 0;
+
+    clock_t inicio = clock();
+    for (size_t i = 0; i < consultas; i++)
+        encontrados += abb_pertenece(abb, cadenas[traza[i]]);
+    double segundos = segundos_desde(inicio);
+
+    inicio = clock();
+    for (size_t i = 0; i < consultas; i++) {
+        if (traza[i] >= ENTRADAS_CACHE) continue;
+        encontrados += abb_pertenece(abb, cadenas[traza[i]]);
+        frecuentes++;
+    }
+    double segundos_frecuentes = segundos_desde(inicio);
+
+    printf("%-40s %10.1f ns/op, claves frecuentes %6.1f ns/op\n", nombre,
+           segundos * 1e9 / (double) consultas, segundos_frecuentes * 1e9 / (double) frecuentes);
+    if (encontrados != consultas + frecuentes)
+        printf("ERROR: se encontraron %zu de %zu claves\n", encontrados, consultas + frecuentes);
+}
+
+static void medir_zipf(size_t cantidad)
+{
+    char (*cadenas)[LARGO_CLAVE];
+    uint64_t* claves = crear_claves(cantidad, &cadenas);
+    size_t* traza = crear_traza_zipf(cantidad, cantidad);
+
+    printf("-- Consultas con distribucion de Zipf, %zu claves\n", cantidad);
+
+    abb_t* abb = abb_crear(strcmp, NULL);
+    for (size_t i = 0; i < cantidad; i++)
+        abb_guardar(abb, cadenas[i], NULL);
+
+    medir_traza(abb, cadenas, traza, cantidad, "abb_pertenece sin cache");
+    abb_cache_activar(abb, ENTRADAS_CACHE);
+    medir_traza(abb, cadenas, traza, cantidad, "abb_pertenece con cache");
+
+    abb_destruir(abb);
+    free(traza);
+    free(claves);
+    free(cadenas);
+}
+
+static int comparar_cadenas(const void* a, const void* b)
+{
+    return strcmp(a, b);
+}
+
+static void medir_cursor(size_t cantidad)
+{
+    char (*cadenas)[LARGO_CLAVE];
+    uint64_t* claves = crear_claves(cantidad, &cadenas);
+    size_t encontrados = 0;
+
+    printf("-- Consultas en orden con cursor, %zu claves\n", cantidad);
+
+    abb_t* abb = abb_crear(strcmp, NULL);
+    for (size_t i = 0; i < cantidad; i++)
+        abb_guardar(abb, cadenas[i], NULL);
+    qsort(cadenas, cantidad, LARGO_CLAVE, comparar_cadenas);
+
+    clock_t inicio = clock();
+    for (size_t i = 0; i < cantidad; i++)
+        encontrados += abb_pertenece(abb, cadenas[i]);
+    imprimir_medicion("abb_pertenece en orden", segundos_desde(inicio), cantidad);
+
+    abb_cursor_t* cursor = abb_cursor_crear(abb);
+    inicio = clock();
+    for (size_t i = 0; i < cantidad; i++)
+        encontrados += abb_cursor_pertenece(cursor, cadenas[i]);
+    imprimir_medicion("abb_cursor_pertenece en orden", segundos_desde(inicio), cantidad);
+
+    if (encontrados != 2 * cantidad)
+        printf("ERROR: se encontraron %zu de %zu claves\n", encontrados, 2 * cantidad);
+
+    abb_cursor_destruir(cursor);
+    abb_destruir(abb);
+    free(claves);
+    free(cadenas);
+}
+
+static bool contar_visitados(const char* clave, void* dato, void* extra)
+{
+    (*(size_t*) extra)++;
+    return true;
+}
+
+static void medir_recorrido(abb_t* abb, char (*cadenas)[LARGO_CLAVE], size_t cantidad, const char* nombre)
+{
+    size_t visitados = 0, encontrados = 0;
+    char etiqueta[64];
+
+    clock_t inicio = clock();
+    abb_in_order(abb, contar_visitados, &visitados);
+    snprintf(etiqueta, sizeof(etiqueta), "abb_in_order %s", nombre);
+    imprimir_medicion(etiqueta, segundos_desde(inicio), visitados);
+
+    inicio = clock();
+    for (size_t i = 0; i < cantidad; i++)
+        encontrados += abb_pertenece(abb, cadenas[i]);
+    snprintf(etiqueta, sizeof(etiqueta), "abb_pertenece %s", nombre);
+    imprimir_medicion(etiqueta, segundos_desde(inicio), cantidad);
+
+    if (visitados != cantidad || encontrados != cantidad)
+        printf("ERROR: se visitaron %zu y encontraron %zu de %zu claves\n", visitados, encontrados, cantidad);
+}
+
+static void medir_compactar(size_t cantidad)
+{
+    char (*cadenas)[LARGO_CLAVE];
+    uint64_t* claves = crear_claves(cantidad, &cadenas);
+
+    printf("-- Compactacion despues de borrar y volver a guardar, %zu claves\n", cantidad);
+
+    // Cada vuelta borra y vuelve a guardar una clave de cada cuatro, para
+    // que los nodos queden mezclados en el heap
+    abb_t* abb = abb_crear(strcmp, NULL);
+    for (size_t i = 0; i < cantidad; i++)
+        abb_guardar(abb, cadenas[i], NULL);
+    for (size_t vuelta = 0; vuelta < 4; vuelta++) {
+        for (size_t i = vuelta; i < cantidad; i += 4)
+            abb_borrar(abb, cadenas[i]);
+        for (size_t i = vuelta; i < cantidad; i += 4)
+            abb_guardar(abb, cadenas[i], NULL);
+    }
+    medir_recorrido(abb, cadenas, cantidad, "antes");
+
+    clock_t inicio = clock();
+    while (abb_compactar(abb, 4096));
+    imprimir_medicion("abb_compactar", segundos_desde(inicio), cantidad);
+
+    medir_recorrido(abb, cadenas, cantidad, "despues");
+
+    abb_destruir(abb);
+    free(claves);
+    free(cadenas);
+}
+
+typedef struct arreglos {
+    const char** claves;
+    void** datos;
+    size_t cantidad;
+} arreglos_t;
+
+static bool agregar_a_arreglos(const char* clave, void* dato, void* extra)
+{
+    arreglos_t* arreglos = extra;
+    arreglos->claves[arreglos->cantidad] = clave;
+    arreglos->datos[arreglos->cantidad++] = dato;
+    return true;
+}
+
+static void medir_exportar(size_t cantidad)
+{
+    char (*cadenas)[LARGO_CLAVE];
+    uint64_t* claves = crear_claves(cantidad, &cadenas);
+
+    printf("-- Exportar e importar en arreglos, %zu claves\n", cantidad);
+
+    abb_t* abb = abb_crear(strcmp, NULL);
+    for (size_t i = 0; i < cantidad; i++)
+        abb_guardar(abb, cadenas[i], NULL);
+
+    arreglos_t arreglos = {malloc(cantidad * sizeof(char*)), malloc(cantidad * sizeof(void*)), 0};
+    clock_t inicio = clock();
+    abb_in_order(abb, agregar_a_arreglos, &arreglos);
+    imprimir_medicion("abb_in_order a arreglos", segundos_desde(inicio), cantidad);
+
+    inicio = clock();
+    abb_exportacion_t* exportacion = abb_exportar_rango(abb, NULL, NULL);
+    imprimir_medicion("abb_exportar_rango", segundos_desde(inicio), cantidad);
+
+    abb_t* copia = abb_crear(strcmp, NULL);
+    inicio = clock();
+    // Uno por uno en el orden original: en orden el abb quedaria degenerado
+    for (size_t i = 0; i < cantidad; i++)
+        abb_guardar(copia, cadenas[i], NULL);
+    imprimir_medicion("abb_guardar uno por uno", segundos_desde(inicio), cantidad);
+    abb_destruir(copia);
+
+    copia = abb_crear(strcmp, NULL);
+    inicio = clock();
+    size_t importados = abb_importar(copia, exportacion);
+    imprimir_medicion("abb_importar", segundos_desde(inicio), cantidad);
+
+    if (exportacion->cantidad != arreglos.cantidad || importados != abb_cantidad(abb))
+        printf("ERROR: se exportaron %zu e importaron %zu de %zu claves\n", exportacion->cantidad, importados, abb_cantidad(abb));
+
+    abb_destruir(copia);
+    abb_exportacion_destruir(exportacion);
+    free(arreglos.claves);
+    free(arreglos.datos);
+    abb_destruir(abb);
+    free(claves);
+    free(cadenas);
+}
+
+typedef struct escritor {
+    abb_t* abb;
+    pthread_mutex_t* mutex;
+    abb_particionado_t* particionado;
+    char (*cadenas)[LARGO_CLAVE];
+    size_t desde;
+    size_t hasta;
+} escritor_t;
+
+static void* escribir_con_mutex(void* extra)
+{
+    escritor_t* escritor = extra;
+    for (size_t i = escritor->desde; i < escritor->hasta; i++) {
+        pthread_mutex_lock(escritor->mutex);
+        abb_guardar(escritor->abb, escritor->cadenas[i], NULL);
+        pthread_mutex_unlock(escritor->mutex);
+    }
+    return NULL;
+}
+
+static void* escribir_particionado(void* extra)
+{
+    escritor_t* escritor = extra;
+    for (size_t i = escritor->desde; i < escritor->hasta; i++)
+        abb_particionado_guardar(escritor->particionado, escritor->cadenas[i], NULL);
+    return NULL;
+}
+
+static void medir_escritores(escritor_t* escritores, void* escribir(void*), size_t cantidad, const char* nombre)
+{
+    pthread_t hilos[HILOS];
+    struct timespec inicio;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    for (size_t i = 0; i < HILOS; i++)
+        pthread_create(&hilos[i], NULL, escribir, &escritores[i]);
+    for (size_t i = 0; i < HILOS; i++)
+        pthread_join(hilos[i], NULL);
+    imprimir_medicion(nombre, segundos_reales_desde(&inicio), cantidad);
+}
+
+static void medir_particionado(size_t cantidad)
+{
+    char (*cadenas)[LARGO_CLAVE];
+    uint64_t* claves = crear_claves(cantidad, &cadenas);
+    // Las claves son hexadecimales al azar: un limite por digito inicial
+    const char* limites[] = {"1", "2", "3", "4", "5", "6", "7", "8", "9", "a", "b", "c", "d", "e", "f"};
+
+    printf("-- Escrituras desde %d hilos, %zu claves\n", HILOS, cantidad);
+
+    abb_t* abb = abb_crear(strcmp, NULL);
+    abb_particionado_t* particionado = abb_particionado_crear(strcmp, NULL, limites, 15);
+    pthread_mutex_t mutex;
+    pthread_mutex_init(&mutex, NULL);
+    escritor_t escritores[HILOS];
+    for (size_t i = 0; i < HILOS; i++) {
+        escritores[i].abb = abb;
+        escritores[i].mutex = &mutex;
+        escritores[i].particionado = particionado;
+        escritores[i].cadenas = cadenas;
+        escritores[i].desde = i * cantidad / HILOS;
+        escritores[i].hasta = (i + 1) * cantidad / HILOS;
+    }
+
+    medir_escritores(escritores, escribir_con_mutex, cantidad, "abb_guardar con un mutex");
+    medir_escritores(escritores, escribir_particionado, cantidad, "abb_particionado_guardar");
+    if (abb_particionado_cantidad(particionado) != abb_cantidad(abb))
+        printf("ERROR: el abb particionado tiene %zu de %zu claves\n", abb_particionado_cantidad(particionado), abb_cantidad(abb));
+
+    pthread_mutex_destroy(&mutex);
+    abb_particionado_destruir(particionado);
+    abb_destruir(abb);
+    free(claves);
+    free(cadenas);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t cantidad = argc > 1 ? (size_t) strtoul(argv[1], NULL, 10) : 200000;
+    srand(1);
+
+    medir_claves_enteras(cantidad);
+    medir_congelado(cantidad);
+    medir_lote(cantidad);
+    medir_filtro(cantidad);
+    medir_zipf(cantidad);
+    medir_cursor(cantidad);
+    medir_compactar(cantidad);
+    medir_exportar(cantidad);
+    medir_particionado(cantidad);
+
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include "filtro.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#define CONTADORES_POR_BLOQUE 128  // 64 bytes de contadores de 4 bits
+#define CONTADOR_MAXIMO 15
+#define FUNCIONES_HASH_MAXIMO 16
+#define LN_2 0.69314718055994530942
+
+typedef struct bloque_filtro {
+    uint8_t contadores[CONTADORES_POR_BLOQUE / 2];
+} bloque_filtro_t;
+
+struct filtro {
+    bloque_filtro_t* bloques;
+    size_t cantidad_bloques;
+    size_t funciones_hash;
+    size_t capacidad;
+};
+
+/* *****************************************************************
+ *                    PRIMITIVAS DEL FILTRO
+ * *****************************************************************/
+
+// Crea un filtro dimensionado para capacidad elementos con la tasa de
+// falsos positivos pedida (entre 0 y 1).
+// Post: devuelve un filtro vacío, o NULL en caso de error.
+filtro_t* filtro_crear(size_t capacidad, double tasa_falsos_positivos)
+{
+    if(tasa_falsos_positivos <= 0 || tasa_falsos_positivos >= 1)
+        return NULL;
+    if(capacidad == 0)
+        capacidad = 1;
+
+    filtro_t* filtro = malloc(sizeof(filtro_t));
+    if(filtro == NULL)
+        return NULL;
+
+    // Dimensionado clasico: m/n = -ln(p) / ln(2)^2 contadores por elemento
+    // y k = m/n * ln(2) funciones de hash
+    double por_elemento = -log(tasa_falsos_positivos) / (LN_2 * LN_2);
+    size_t funciones = (size_t) (por_elemento * LN_2 + 0.5);
+    if(funciones < 1)
+        funciones = 1;
+    if(funciones > FUNCIONES_HASH_MAXIMO)
+        funciones = FUNCIONES_HASH_MAXIMO;
+
+    size_t contadores = (size_t) ceil(por_elemento * (double) capacidad);
+    filtro->cantidad_bloques = (contadores + CONTADORES_POR_BLOQUE - 1) / CONTADORES_POR_BLOQUE;
+    filtro->bloques = calloc(filtro->cantidad_bloques, sizeof(bloque_filtro_t));
+    if(filtro->bloques == NULL) {
+        free(filtro);
+        return NULL;
+    }
+    filtro->funciones_hash = funciones;
+    filtro->capacidad = capacidad;
+    return filtro;
+}
+
+// Destruye el filtro.
+// Pre: el filtro fue creado.
+void filtro_destruir(filtro_t *filtro)
+{
+    free(filtro->bloques);
+    free(filtro);
+}
+
+// Elige el bloque con la parte alta del hash y deriva las posiciones dentro
+// del bloque con doble hashing sobre la parte baja.
+static bloque_filtro_t* filtro_bloque(const filtro_t *filtro, uint64_t hash, size_t *inicio, size_t *paso)
+{
+    *inicio = (size_t) (hash & 0xFFFF);
+    *paso = (size_t) ((hash >> 16) & 0xFFFF) | 1;  // impar: recorre las 128 posiciones
+    return &filtro->bloques[(hash >> 32) % filtro->cantidad_bloques];
+}
+
+static unsigned filtro_leer(const bloque_filtro_t *bloque, size_t posicion)
+{
+    uint8_t par = bloque->contadores[posicion / 2];
+    return posicion % 2 ? par >> 4 : par & 0x0F;
+}
+
+static void filtro_escribir(bloque_filtro_t *bloque, size_t posicion, unsigned valor)
+{
+    uint8_t* par = &bloque->contadores[posicion / 2];
+    *par = posicion % 2 ? (uint8_t) ((*par & 0x0F) | (valor << 4)) : (uint8_t) ((*par & 0xF0) | valor);
+}
+
+// Agrega un elemento por su hash.
+// Pre: el filtro fue creado.
+void filtro_agregar(filtro_t *filtro, uint64_t hash)
+{
+    size_t inicio, paso;
+    bloque_filtro_t* bloque = filtro_bloque(filtro, hash, &inicio, &paso);
+    for(size_t i = 0; i < filtro->funciones_hash; i++) {
+        size_t posicion = (inicio + i * paso) % CONTADORES_POR_BLOQUE;
+        unsigned valor = filtro_leer(bloque, posicion);
+        if(valor < CONTADOR_MAXIMO)
+            filtro_escribir(bloque, posicion, valor + 1);
+    }
+}
+
+// Quita un elemento por su hash. Los contadores saturados no se
+// decrementan, para no dar nunca falsos negativos.
+// Pre: el filtro fue creado y el elemento habia sido agregado.
+void filtro_quitar(filtro_t *filtro, uint64_t hash)
+{
+    size_t inicio, paso;
+    bloque_filtro_t* bloque = filtro_bloque(filtro, hash, &inicio, &paso);
+    for(size_t i = 0; i < filtro->funciones_hash; i++) {
+        size_t posicion = (inicio + i * paso) % CONTADORES_POR_BLOQUE;
+        unsigned valor = filtro_leer(bloque, posicion);
+        if(valor > 0 && valor < CONTADOR_MAXIMO)
+            filtro_escribir(bloque, posicion, valor - 1);
+    }
+}
+
+// Devuelve false si el elemento seguro no fue agregado, true si tal vez sí.
+// Pre: el filtro fue creado.
+bool filtro_puede_estar(const filtro_t *filtro, uint64_t hash)
+{
+    size_t inicio, paso;
+    const bloque_filtro_t* bloque = filtro_bloque(filtro, hash, &inicio, &paso);
+    for(size_t i = 0; i < filtro->funciones_hash; i++) {
+        if(filtro_leer(bloque, (inicio + i * paso) % CONTADORES_POR_BLOQUE) == 0)
+            return false;
+    }
+    return true;
+}
+
+// Quita todos los elementos.
+// Pre: el filtro fue creado.
+void filtro_vaciar(filtro_t *filtro)
+{
+    memset(filtro->bloques, 0, filtro->cantidad_bloques * sizeof(bloque_filtro_t));
+}
+
+// Devuelve la cantidad de elementos para la que se dimensionó el filtro.
+// Pre: el filtro fue creado.
+size_t filtro_capacidad(const filtro_t *filtro)
+{
+    return filtro->capacidad;
+}
+
+// Devuelve la cantidad de hashes que se derivan por elemento.
+// Pre: el filtro fue creado.
+size_t filtro_funciones_hash(const filtro_t *filtro)
+{
+    return filtro->funciones_hash;
+}
+
+// Devuelve los bytes que ocupa el filtro.
+// Pre: el filtro fue creado.
+size_t filtro_memoria(const filtro_t *filtro)
+{
+    return sizeof(filtro_t) + filtro->cantidad_bloques * sizeof(bloque_filtro_t);
+}
+
+// Devuelve la tasa de falsos positivos esperada con elementos agregados.
+// Pre: el filtro fue creado.
+double filtro_tasa_estimada(const filtro_t *filtro, size_t elementos)
+{
+    double contadores = (double) (filtro->cantidad_bloques * CONTADORES_POR_BLOQUE);
+    double k = (double) filtro->funciones_hash;
+    return pow(1 - exp(-k * (double) elementos / contadores), k);
+}
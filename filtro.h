@@ -0,0 +1,71 @@
+#ifndef _FILTRO_H
+#define _FILTRO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* *****************************************************************
+ *                DEFINICION DE LOS TIPOS DE DATOS
+ * *****************************************************************/
+
+/* Filtro de pertenencia aproximada (filtro de Bloom con contadores). Puede
+ * responder que un elemento no esta con certeza, o que tal vez esta. Trabaja
+ * sobre hashes de 64 bits que calcula quien lo usa.
+ *
+ * Los contadores de 4 bits permiten quitar elementos. Los hashes de cada
+ * elemento caen todos en un mismo bloque de 64 bytes, asi que cada consulta
+ * lee una sola linea de cache.  */
+
+struct filtro;  // Definición completa en filtro.c.
+typedef struct filtro filtro_t;
+
+
+/* *****************************************************************
+ *                    PRIMITIVAS DEL FILTRO
+ * *****************************************************************/
+
+// Crea un filtro dimensionado para capacidad elementos con la tasa de
+// falsos positivos pedida (entre 0 y 1).
+// Post: devuelve un filtro vacío, o NULL en caso de error.
+filtro_t* filtro_crear(size_t capacidad, double tasa_falsos_positivos);
+
+// Destruye el filtro.
+// Pre: el filtro fue creado.
+void filtro_destruir(filtro_t *filtro);
+
+// Agrega un elemento por su hash.
+// Pre: el filtro fue creado.
+void filtro_agregar(filtro_t *filtro, uint64_t hash);
+
+// Quita un elemento por su hash. Los contadores saturados no se
+// decrementan, para no dar nunca falsos negativos.
+// Pre: el filtro fue creado y el elemento habia sido agregado.
+void filtro_quitar(filtro_t *filtro, uint64_t hash);
+
+// Devuelve false si el elemento seguro no fue agregado, true si tal vez sí.
+// Pre: el filtro fue creado.
+bool filtro_puede_estar(const filtro_t *filtro, uint64_t hash);
+
+// Quita todos los elementos.
+// Pre: el filtro fue creado.
+void filtro_vaciar(filtro_t *filtro);
+
+// Devuelve la cantidad de elementos para la que se dimensionó el filtro.
+// Pre: el filtro fue creado.
+size_t filtro_capacidad(const filtro_t *filtro);
+
+// Devuelve la cantidad de hashes que se derivan por elemento.
+// Pre: el filtro fue creado.
+size_t filtro_funciones_hash(const filtro_t *filtro);
+
+// Devuelve los bytes que ocupa el filtro.
+// Pre: el filtro fue creado.
+size_t filtro_memoria(const filtro_t *filtro);
+
+// Devuelve la tasa de falsos positivos esperada con elementos agregados.
+// Pre: el filtro fue creado.
+double filtro_tasa_estimada(const filtro_t *filtro, size_t elementos);
+
+#endif // _FILTRO_H
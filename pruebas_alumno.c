@@ -1,16 +1,24 @@
 #include "abb.h"
+#include "abb_generico.h"
+#include "abb_entero.h"
+#include "abb_particionado.h"
 #include "testing.h"
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include <unistd.h>  // For ssize_t in Linux.
 
 /* ******************************************************************
  *                   PRUEBAS UNITARIAS ALUMNO
  * *****************************************************************/
 
+#define LARGO_DEGENERADO 300000  // Niveles de los abbs degenerados de prueba
+
+ABB_DEFINE(abb_int, int, int, ABB_COMPARAR_ENTEROS)
+
 
 static void prueba_crear_abb_vacio()
 {
@@ -310,7 +318,6 @@ static ssize_t buscar(const char* clave, char* claves[], size_t largo)
 
 static void prueba_abb_iterar()
 {
-    return;
     abb_t* abb = abb_crear(strcmp, NULL);
 
     char *claves[] = {"perro", "gato", "vaca"};
@@ -368,7 +375,6 @@ static void prueba_abb_iterar()
 
 static void prueba_abb_iterar_volumen(size_t largo)
 {
-    return;
     abb_t* abb = abb_crear(strcmp, NULL);
 
     const size_t largo_clave = 10;
@@ -433,6 +439,980 @@ static void prueba_abb_iterar_volumen(size_t largo)
     abb_destruir(abb);
 }
 
+static bool contar_hasta_tres(const char* clave, void* dato, void* extra)
+{
+    size_t* contador = extra;
+    (*contador)++;
+    return *contador < 3;
+}
+
+static void prueba_abb_iterar_con_cambios()
+{
+    abb_t* abb = abb_crear(strcmp, NULL);
+
+    char *claves[] = {"m", "f", "t", "c", "h", "p", "w", "g"};
+    for (size_t i = 0; i < 8; i++)
+        abb_guardar(abb, claves[i], claves[i]);
+
+    // El iterador queda parado en "h" mientras se modifica el resto del arbol
+    abb_iter_t* iter = abb_iter_in_crear(abb);
+    while (strcmp(abb_iter_in_ver_actual(iter), "h") != 0)
+        abb_iter_in_avanzar(iter);
+
+    print_test("Prueba abb insertar con iterador activo", abb_guardar(abb, "j", "j"));
+    print_test("Prueba abb borrar nodo con dos hijos con iterador activo", abb_borrar(abb, "f") == claves[1]);
+    print_test("Prueba abb iterador sigue en h", strcmp(abb_iter_in_ver_actual(iter), "h") == 0);
+    abb_iter_in_avanzar(iter);
+    print_test("Prueba abb iterador ve la clave insertada", strcmp(abb_iter_in_ver_actual(iter), "j") == 0);
+    abb_iter_in_avanzar(iter);
+    print_test("Prueba abb iterador sigue en orden", strcmp(abb_iter_in_ver_actual(iter), "m") == 0);
+    abb_iter_in_destruir(iter);
+
+    // El recorrido interno corta apenas visitar devuelve false
+    size_t contador = 0;
+    abb_in_order(abb, contar_hasta_tres, &contador);
+    print_test("Prueba abb in order corta al devolver false", contador == 3);
+
+    abb_destruir(abb);
+}
+
+static void prueba_abb_iterar_reverso()
+{
+    abb_t* abb = abb_crear(strcmp, NULL);
+
+    print_test("Prueba abb minimo de abb vacio es NULL", !abb_minimo(abb));
+    print_test("Prueba abb maximo de abb vacio es NULL", !abb_maximo(abb));
+    abb_iter_t* iter = abb_iter_in_crear_reverso(abb);
+    print_test("Prueba abb iter reverso de abb vacio esta al principio", abb_iter_in_al_principio(iter));
+    abb_iter_in_destruir(iter);
+
+    char *claves[] = {"m", "f", "t", "c", "h", "p", "w"};
+    for (size_t i = 0; i < 7; i++)
+        abb_guardar(abb, claves[i], claves[i]);
+
+    print_test("Prueba abb minimo es c", strcmp(abb_minimo(abb), "c") == 0);
+    print_test("Prueba abb maximo es w", strcmp(abb_maximo(abb), "w") == 0);
+
+    // Recorre de mayor a menor
+    char recorrido[8] = "";
+    iter = abb_iter_in_crear_reverso(abb);
+    for (size_t i = 0; !abb_iter_in_al_principio(iter); i++) {
+        recorrido[i] = abb_iter_in_ver_actual(iter)[0];
+        abb_iter_in_retroceder(iter);
+    }
+    print_test("Prueba abb iter reverso recorre de mayor a menor", strcmp(recorrido, "wtpmhfc") == 0);
+    print_test("Prueba abb iter reverso no esta al final", !abb_iter_in_al_final(iter));
+    print_test("Prueba abb iter retroceder al principio es false", !abb_iter_in_retroceder(iter));
+    print_test("Prueba abb iter avanzar desde el principio es true", abb_iter_in_avanzar(iter));
+    print_test("Prueba abb iter vuelve al menor", strcmp(abb_iter_in_ver_actual(iter), "c") == 0);
+    abb_iter_in_destruir(iter);
+
+    // Avanza hasta el final y vuelve un paso
+    iter = abb_iter_in_crear(abb);
+    while (!abb_iter_in_al_final(iter))
+        abb_iter_in_avanzar(iter);
+    print_test("Prueba abb iter retroceder desde el final es true", abb_iter_in_retroceder(iter));
+    print_test("Prueba abb iter vuelve al mayor", strcmp(abb_iter_in_ver_actual(iter), "w") == 0);
+    abb_iter_in_retroceder(iter);
+    abb_iter_in_avanzar(iter);
+    print_test("Prueba abb iter avanzar y retroceder es bidireccional", strcmp(abb_iter_in_ver_actual(iter), "w") == 0);
+    abb_iter_in_destruir(iter);
+
+    abb_destruir(abb);
+}
+
+/* Concatena las claves del abb en orden, para comparar contenidos */
+static bool concatenar_clave(const char* clave, void* dato, void* extra)
+{
+    strcat(extra, clave);
+    return true;
+}
+
+static abb_t* crear_abb_con_claves(const char* claves, abb_destruir_dato_t destruir)
+{
+    abb_t* abb = abb_crear(strcmp, destruir);
+    for (size_t i = 0; claves[i]; i++) {
+        char clave[2] = {claves[i], '\0'};
+        abb_guardar(abb, clave, destruir ? malloc(sizeof(int)) : NULL);
+    }
+    return abb;
+}
+
+static bool abb_tiene_claves(abb_t* abb, const char* esperadas)
+{
+    char recorrido[64] = "";
+    abb_in_order(abb, concatenar_clave, recorrido);
+    return strcmp(recorrido, esperadas) == 0 && abb_cantidad(abb) == strlen(esperadas);
+}
+
+/* Arma un abb con claves cada paso desde primera, juntando de a un nodo: el
+resultado es una rama de cantidad niveles, armada en tiempo lineal */
+static abb_t* crear_abb_degenerado(size_t cantidad, size_t primera, size_t paso)
+{
+    abb_t* abb = abb_crear(strcmp, NULL);
+    char clave[24];
+    for (size_t i = 0; i < cantidad; i++) {
+        abb_t* nodo = abb_crear(strcmp, NULL);
+        sprintf(clave, "%08zu", primera + i * paso);
+        abb_guardar(nodo, clave, NULL);
+        abb_juntar(abb, nodo);
+        abb_destruir(nodo);
+    }
+    return abb;
+}
+
+/* Arma un abb con claves cada paso desde primera guardadas salteadas, para
+que quede aproximadamente balanceado. Cada dato es su propia clave */
+static abb_t* crear_abb_salteado(size_t cantidad, size_t primera, size_t paso)
+{
+    abb_t* abb = abb_crear(strcmp, free);
+    for (size_t i = 0; i < cantidad; i++) {
+        char* clave = malloc(24);
+        sprintf(clave, "%08zu", primera + (i * 7919 % cantidad) * paso);
+        abb_guardar(abb, clave, clave);
+    }
+    return abb;
+}
+
+static void prueba_abb_conjuntos()
+{
+    abb_t* a = crear_abb_con_claves("mfthcpw", free);
+    abb_t* b = crear_abb_con_claves("dhpxa", free);
+
+    print_test("Prueba abb unir", abb_unir(a, b));
+    print_test("Prueba abb unir contiene ambos", abb_tiene_claves(a, "acdfhmptwx"));
+    print_test("Prueba abb unir deja vacio al otro", abb_cantidad(b) == 0 && !abb_minimo(b));
+    abb_destruir(b);
+
+    b = crear_abb_con_claves("cmzwbf", NULL);
+    print_test("Prueba abb intersectar", abb_intersectar(a, b));
+    print_test("Prueba abb intersectar deja las comunes", abb_tiene_claves(a, "cfmw"));
+    print_test("Prueba abb intersectar no modifica al otro", abb_tiene_claves(b, "bcfmwz"));
+    abb_destruir(b);
+
+    b = crear_abb_con_claves("wcq", NULL);
+    print_test("Prueba abb diferencia", abb_diferencia(a, b));
+    print_test("Prueba abb diferencia quita las del otro", abb_tiene_claves(a, "fm"));
+    abb_destruir(b);
+    abb_destruir(a);
+
+    a = crear_abb_con_claves("mfthcpwa", free);
+    b = abb_partir(a, "m");
+    print_test("Prueba abb partir deja las menores", abb_tiene_claves(a, "acfh"));
+    print_test("Prueba abb partir devuelve las mayores o iguales", abb_tiene_claves(b, "mptw"));
+    print_test("Prueba abb juntar desordenado es false", !abb_juntar(b, a));
+    print_test("Prueba abb juntar", abb_juntar(a, b));
+    print_test("Prueba abb juntar contiene todo", abb_tiene_claves(a, "acfhmptw"));
+    void* dato = abb_borrar(a, "m");
+    print_test("Prueba abb borrar despues de juntar", dato);
+    free(dato);
+    free(abb_borrar(a, "h"));
+    print_test("Prueba abb iterar despues de juntar", abb_tiene_claves(a, "acfptw"));
+    abb_destruir(b);
+
+    b = abb_partir(a, "zz");
+    print_test("Prueba abb partir al final deja vacio el nuevo", abb_cantidad(b) == 0 && abb_cantidad(a) == 6);
+    abb_destruir(b);
+    abb_destruir(a);
+
+    // Un abb grande y uno chico: las claves del chico se buscan de a una
+    a = crear_abb_salteado(1000, 0, 1);
+    b = crear_abb_salteado(10, 995, 1);
+    char* dato_chico = abb_obtener(b, "00000999");
+    print_test("Prueba abb unir chico en grande", abb_unir(a, b) && abb_cantidad(a) == 1005);
+    print_test("Prueba abb unir chico en grande queda el dato del otro", abb_obtener(a, "00000999") == dato_chico && abb_pertenece(a, "00001004"));
+    abb_destruir(b);
+    b = crear_abb_salteado(10, 1000, 1);
+    abb_t* c = crear_abb_salteado(1000, 0, 2);
+    dato_chico = abb_obtener(c, "00001000");
+    print_test("Prueba abb unir grande en chico", abb_unir(b, c) && abb_cantidad(b) == 1005);
+    print_test("Prueba abb unir grande en chico queda el dato del otro", abb_obtener(b, "00001000") == dato_chico && abb_pertenece(b, "00001009"));
+    abb_destruir(c);
+    c = crear_abb_salteado(10, 0, 100);
+    print_test("Prueba abb diferencia con chico", abb_diferencia(a, c) && abb_cantidad(a) == 995 && !abb_pertenece(a, "00000900") && abb_pertenece(a, "00000901"));
+    abb_destruir(c);
+    c = crear_abb_salteado(10, 0, 75);
+    print_test("Prueba abb intersectar chico con grande", abb_intersectar(c, b) && abb_cantidad(c) == 5 && abb_pertenece(c, "00000150") && !abb_pertenece(c, "00000075"));
+    abb_destruir(c);
+    abb_destruir(b);
+    abb_destruir(a);
+
+    // Abbs degenerados, mas profundos de lo que aguantaria una recursion
+    size_t largo = LARGO_DEGENERADO;
+    a = crear_abb_degenerado(largo, 0, 2);
+    b = crear_abb_degenerado(largo, 1, 2);
+    print_test("Prueba abb unir degenerados", abb_unir(a, b) && abb_cantidad(a) == 2 * largo);
+    abb_destruir(b);
+
+    // Las claves de largo / 2 a 3 * largo / 2
+    b = crear_abb_degenerado(largo, largo / 2, 1);
+    print_test("Prueba abb intersectar con degenerado", abb_intersectar(a, b) && abb_cantidad(a) == largo);
+    c = crear_abb_degenerado(largo, 0, 1);
+    print_test("Prueba abb intersectar degenerado", abb_intersectar(c, b) && abb_cantidad(c) == largo / 2);
+    abb_destruir(c);
+
+    // Las pares desde largo / 2
+    c = crear_abb_degenerado(largo / 2, largo / 2, 2);
+    print_test("Prueba abb diferencia con degenerado", abb_diferencia(a, c) && abb_cantidad(a) == largo / 2);
+    print_test("Prueba abb diferencia con degenerado deja las impares", !abb_pertenece(a, "00150000") && abb_pertenece(a, "00150001"));
+    print_test("Prueba abb diferencia degenerado", abb_diferencia(b, c) && abb_cantidad(b) == largo / 2);
+    abb_destruir(c);
+    abb_destruir(b);
+    abb_destruir(a);
+}
+
+static bool sumar_en_orden(int clave, int* valor, void* extra)
+{
+    int* anterior = extra;
+    bool ok = clave > anterior[0] && *valor == clave * 2;
+    anterior[0] = clave;
+    anterior[1] += ok;
+    return ok;
+}
+
+static bool cortar_en_orden(int clave, int* valor, void* extra)
+{
+    int* restantes = extra;
+    return --*restantes > 0;
+}
+
+static void prueba_abb_generico(int largo)
+{
+    abb_int_t* abb = abb_int_crear();
+
+    print_test("Prueba abb generico crear", abb);
+    print_test("Prueba abb generico obtener en vacio es NULL", !abb_int_obtener(abb, 7));
+    print_test("Prueba abb generico borrar en vacio es false", !abb_int_borrar(abb, 7, NULL));
+
+    // Inserta enteros desordenados sin convertirlos a cadenas ni pedir memoria para los valores
+    bool ok = true;
+    for (int i = 0; i < largo && ok; i++) {
+        int clave = (i * 7919) % largo;
+        ok = abb_int_guardar(abb, clave, clave * 2);
+    }
+    print_test("Prueba abb generico guardar muchos elementos", ok);
+    print_test("Prueba abb generico la cantidad es correcta", abb_int_cantidad(abb) == largo);
+
+    for (int i = 0; i < largo && ok; i++) {
+        int* valor = abb_int_obtener(abb, i);
+        ok = valor && *valor == i * 2;
+    }
+    print_test("Prueba abb generico obtener muchos elementos", ok);
+
+    int anterior[2] = {-1, 0};
+    abb_int_in_order(abb, sumar_en_orden, anterior);
+    print_test("Prueba abb generico in order recorre en orden", anterior[1] == largo);
+
+    // Cortar a mitad del recorrido tiene que deshacer los enlaces temporales
+    int restantes = largo / 3;
+    abb_int_in_order(abb, cortar_en_orden, &restantes);
+    for (int i = 0; i < largo && ok; i++)
+        ok = abb_int_pertenece(abb, i);
+    anterior[0] = -1;
+    anterior[1] = 0;
+    abb_int_in_order(abb, sumar_en_orden, anterior);
+    print_test("Prueba abb generico in order cortado deja el arbol intacto", restantes == 0 && ok && anterior[1] == largo);
+
+    *abb_int_obtener(abb, 3) = 10;
+    int valor = 0;
+    print_test("Prueba abb generico guardar reemplaza", abb_int_guardar(abb, 5, 11) && *abb_int_obtener(abb, 5) == 11);
+    print_test("Prueba abb generico borrar devuelve el valor", abb_int_borrar(abb, 3, &valor) && valor == 10);
+    print_test("Prueba abb generico pertenece borrado es false", !abb_int_pertenece(abb, 3));
+
+    for (int i = 0; i < largo && ok; i += 2)
+        ok = i == 3 || abb_int_borrar(abb, i, NULL);
+    print_test("Prueba abb generico borrar muchos elementos", ok);
+    print_test("Prueba abb generico quedan los impares", abb_int_cantidad(abb) == largo / 2 - 1 && abb_int_pertenece(abb, 1));
+
+    abb_int_destruir(abb);
+}
+
+static void prueba_abb_entero()
+{
+    abb_u64_t* abb = abb_u64_crear();
+    abb_i64_t* negativos = abb_i64_crear();
+    char *valor1 = "uno", *valor2 = "dos";
+
+    print_test("Prueba abb u64 nodo de 32 bytes", sizeof(abb_u64_nodo_t) == 2 * sizeof(uint64_t) + 2 * sizeof(void*));
+    print_test("Prueba abb u64 guardar clave grande", abb_u64_guardar(abb, UINT64_MAX, valor1));
+    print_test("Prueba abb u64 guardar clave 0", abb_u64_guardar(abb, 0, valor2));
+    print_test("Prueba abb u64 obtener clave grande", *abb_u64_obtener(abb, UINT64_MAX) == valor1);
+    print_test("Prueba abb u64 obtener clave 0", *abb_u64_obtener(abb, 0) == valor2);
+    print_test("Prueba abb u64 clave intermedia no pertenece", !abb_u64_pertenece(abb, UINT64_MAX / 2));
+
+    print_test("Prueba abb i64 guardar negativo", abb_i64_guardar(negativos, INT64_MIN, valor1));
+    print_test("Prueba abb i64 guardar positivo", abb_i64_guardar(negativos, 1, valor2));
+    print_test("Prueba abb i64 obtener negativo", *abb_i64_obtener(negativos, INT64_MIN) == valor1);
+    print_test("Prueba abb i64 -1 no pertenece", !abb_i64_pertenece(negativos, -1));
+
+    abb_u64_destruir(abb);
+    abb_i64_destruir(negativos);
+}
+
+static bool concatenar_clave_congelada(const char* clave, void* dato, void* extra)
+{
+    strcat(extra, clave);
+    return strlen(extra) < 5;
+}
+
+static void prueba_abb_congelar(size_t largo)
+{
+    abb_congelado_t* vacio = abb_congelar(abb_crear(strcmp, NULL));
+    print_test("Prueba abb congelar abb vacio", vacio && abb_congelado_cantidad(vacio) == 0);
+    print_test("Prueba abb congelado vacio no tiene claves", !abb_congelado_pertenece(vacio, ""));
+    abb_congelado_destruir(vacio);
+
+    abb_t* abb = abb_crear(strcmp, free);
+    char (*claves)[10] = malloc(largo * 10);
+    bool ok = true;
+    for (size_t i = 0; i < largo && ok; i++) {
+        // Solo claves pares, para buscar tambien las impares que no estan
+        sprintf(claves[i], "%08zu", 2 * i);
+        int* valor = malloc(sizeof(int));
+        *valor = (int) i;
+        ok = abb_guardar(abb, claves[i], valor);
+    }
+
+    abb_congelado_t* congelado = abb_congelar(abb);
+    print_test("Prueba abb congelar", congelado);
+    print_test("Prueba abb congelado la cantidad es correcta", abb_congelado_cantidad(congelado) == largo);
+
+    for (size_t i = 0; i < largo && ok; i++) {
+        int* valor = abb_congelado_obtener(congelado, claves[i]);
+        ok = valor && *valor == (int) i && abb_congelado_pertenece(congelado, claves[i]);
+    }
+    print_test("Prueba abb congelado obtener todas las claves", ok);
+
+    char ausente[10];
+    for (size_t i = 0; i < largo && ok; i++) {
+        sprintf(ausente, "%08zu", 2 * i + 1);
+        ok = !abb_congelado_obtener(congelado, ausente);
+    }
+    print_test("Prueba abb congelado no encuentra claves ausentes", ok && !abb_congelado_pertenece(congelado, ""));
+
+    char recorrido[64] = "";
+    abb_congelado_in_order(congelado, concatenar_clave_congelada, recorrido);
+    print_test("Prueba abb congelado in order empieza por la menor y corta", strcmp(recorrido, "00000000") == 0);
+    print_test("Prueba abb congelado informa su memoria", abb_congelado_memoria(congelado) > largo * 9);
+
+    free(claves);
+    abb_congelado_destruir(congelado);
+}
+
+static void prueba_abb_lote(size_t largo)
+{
+    abb_t* abb = abb_crear(strcmp, free);
+    abb_guardar(abb, "00000010", malloc(sizeof(int)));
+
+    // Lote desordenado, con una clave que ya esta y una repetida dentro del lote
+    const char* claves[] = {"00000020", "00000010", "00000005", "00000020", "00000015"};
+    void* datos[5];
+    bool resultados[5];
+    for (size_t i = 0; i < 5; i++)
+        datos[i] = malloc(sizeof(int));
+
+    print_test("Prueba abb guardar lote", abb_guardar_lote(abb, claves, datos, 5, resultados) == 5);
+    print_test("Prueba abb guardar lote informa cada clave", resultados[0] && resultados[2] && resultados[4]);
+    print_test("Prueba abb guardar lote la cantidad es correcta", abb_cantidad(abb) == 4);
+    print_test("Prueba abb guardar lote reemplaza la clave existente", abb_obtener(abb, "00000010") == datos[1]);
+    print_test("Prueba abb guardar lote la repetida queda con el ultimo dato", abb_obtener(abb, "00000020") == datos[3]);
+    print_test("Prueba abb guardar lote queda en orden", strcmp(abb_minimo(abb), "00000005") == 0);
+
+    // Las claves NULL se saltean, sin llegar a compararlas
+    abb_t* con_nulas = abb_crear(strcmp, NULL);
+    const char* nulas[] = {"b", NULL, "a"};
+    void* datos_nulas[] = {&largo, &largo, &largo};
+    bool resultados_nulas[3];
+    print_test("Prueba abb guardar lote con clave NULL", abb_guardar_lote(con_nulas, nulas, datos_nulas, 3, resultados_nulas) == 2);
+    print_test("Prueba abb guardar lote la clave NULL no se guarda", !resultados_nulas[1] && abb_tiene_claves(con_nulas, "ab"));
+    print_test("Prueba abb borrar lote con clave NULL", abb_borrar_lote(con_nulas, nulas, 3, datos_nulas) == 2 && !datos_nulas[1]);
+    print_test("Prueba abb borrar lote con clave NULL deja vacio", abb_cantidad(con_nulas) == 0);
+    abb_destruir(con_nulas);
+
+    // Muchas claves, en un lote que incluye a las que ya estan
+    char (*muchas)[10] = malloc(largo * 10);
+    const char** lote = malloc(largo * sizeof(char*));
+    void** valores = malloc(largo * sizeof(void*));
+    for (size_t i = 0; i < largo; i++) {
+        sprintf(muchas[i], "%08zu", (i * 7919) % largo);
+        lote[i] = muchas[i];
+        valores[i] = malloc(sizeof(int));
+    }
+    print_test("Prueba abb guardar lote grande", abb_guardar_lote(abb, lote, valores, largo, NULL) == largo);
+    print_test("Prueba abb guardar lote grande la cantidad es correcta", abb_cantidad(abb) == largo);
+
+    bool ok = true;
+    for (size_t i = 0; i < largo && ok; i++)
+        ok = abb_obtener(abb, lote[i]) == valores[i];
+    print_test("Prueba abb guardar lote grande obtener todas", ok);
+
+    // Se borra la mitad en un lote, junto con una clave inexistente
+    size_t mitad = largo / 2;
+    void** borrados = malloc((mitad + 1) * sizeof(void*));
+    lote[mitad] = "no esta";
+    print_test("Prueba abb borrar lote", abb_borrar_lote(abb, lote, mitad + 1, borrados) == mitad);
+    for (size_t i = 0; i < mitad && ok; i++) {
+        ok = borrados[i] == valores[i] && !abb_pertenece(abb, lote[i]);
+        free(borrados[i]);
+    }
+    print_test("Prueba abb borrar lote devuelve los datos", ok);
+    print_test("Prueba abb borrar lote la clave inexistente es NULL", !borrados[mitad]);
+    print_test("Prueba abb borrar lote la cantidad es correcta", abb_cantidad(abb) == largo - mitad);
+    print_test("Prueba abb borrar lote quedan las demas", abb_obtener(abb, lote[largo - 1]) == valores[largo - 1]);
+
+    free(borrados);
+    free(muchas);
+    free(lote);
+    free(valores);
+    abb_destruir(abb);
+}
+
+static void prueba_abb_filtro(size_t largo)
+{
+    abb_t* abb = abb_crear(strcmp, NULL);
+    abb_filtro_estadisticas_t estadisticas;
+
+    print_test("Prueba abb sin filtro no hay estadisticas", !abb_filtro_estadisticas(abb, &estadisticas));
+    print_test("Prueba abb filtro con tasa invalida es false", !abb_filtro_activar(abb, largo, 1.5));
+    abb_guardar(abb, "previa", NULL);
+    print_test("Prueba abb activar filtro", abb_filtro_activar(abb, largo / 4, 0.01));
+    print_test("Prueba abb filtro conserva las claves previas", abb_pertenece(abb, "previa"));
+
+    // Se guarda mas de lo que entra en el filtro, para que se agrande
+    char (*claves)[10] = malloc(largo * 10);
+    bool ok = true;
+    for (size_t i = 0; i < largo && ok; i++) {
+        sprintf(claves[i], "%08zu", 2 * i);
+        ok = abb_guardar(abb, claves[i], claves[i]);
+    }
+    for (size_t i = 0; i < largo && ok; i++)
+        ok = abb_obtener(abb, claves[i]) == claves[i];
+    print_test("Prueba abb filtro sin falsos negativos", ok);
+
+    print_test("Prueba abb filtro estadisticas", abb_filtro_estadisticas(abb, &estadisticas));
+    print_test("Prueba abb filtro se agrando con el arbol", estadisticas.capacidad >= abb_cantidad(abb));
+    print_test("Prueba abb filtro informa memoria", estadisticas.memoria > 0 && estadisticas.funciones_hash > 0);
+    print_test("Prueba abb filtro tasa estimada cerca de la pedida", estadisticas.tasa_falsos_positivos < 0.02);
+
+    char ausente[10];
+    size_t falsos_positivos = 0;
+    for (size_t i = 0; i < largo; i++) {
+        sprintf(ausente, "%08zu", 2 * i + 1);
+        falsos_positivos += abb_pertenece(abb, ausente);
+    }
+    print_test("Prueba abb filtro claves ausentes no pertenecen", falsos_positivos == 0);
+
+    // Borrar y partir tambien mantienen el filtro
+    for (size_t i = 0; i < largo && ok; i += 2)
+        ok = abb_borrar(abb, claves[i]) == claves[i];
+    abb_t* mayores = abb_partir(abb, claves[largo / 2]);
+    for (size_t i = 1; i < largo && ok; i += 2)
+        ok = abb_pertenece(i < largo / 2 ? abb : mayores, claves[i]) && !abb_pertenece(i < largo / 2 ? mayores : abb, claves[i]);
+    print_test("Prueba abb filtro despues de borrar y partir", ok);
+    print_test("Prueba abb filtro juntar", abb_juntar(abb, mayores) && abb_pertenece(abb, claves[largo - 1]));
+
+    abb_filtro_desactivar(abb);
+    print_test("Prueba abb desactivar filtro", !abb_filtro_estadisticas(abb, &estadisticas) && abb_pertenece(abb, claves[1]));
+
+    free(claves);
+    abb_destruir(mayores);
+    abb_destruir(abb);
+
+    // Unir y juntar agrandan el filtro como guardar
+    abb = abb_crear(strcmp, NULL);
+    abb_filtro_activar(abb, 4, 0.01);
+    abb_t* otro = crear_abb_degenerado(largo, 0, 2);
+    print_test("Prueba abb filtro unir", abb_unir(abb, otro) && abb_filtro_estadisticas(abb, &estadisticas));
+    print_test("Prueba abb filtro se agrando al unir", estadisticas.capacidad >= largo && estadisticas.tasa_falsos_positivos < 0.02);
+    abb_destruir(otro);
+    otro = crear_abb_degenerado(2 * largo, 2 * largo, 1);
+    print_test("Prueba abb filtro juntar otro abb", abb_juntar(abb, otro) && abb_filtro_estadisticas(abb, &estadisticas));
+    print_test("Prueba abb filtro se agrando al juntar", estadisticas.capacidad >= 3 * largo && estadisticas.tasa_falsos_positivos < 0.02);
+    abb_destruir(otro);
+    abb_destruir(abb);
+}
+
+static void prueba_abb_cache()
+{
+    abb_t* abb = abb_crear(strcmp, NULL);
+    char *claves[] = {"perro", "gato", "vaca", "pato"};
+
+    print_test("Prueba abb activar cache de 0 entradas es false", !abb_cache_activar(abb, 0));
+    print_test("Prueba abb activar cache", abb_cache_activar(abb, 3));
+    for (size_t i = 0; i < 4; i++)
+        abb_guardar(abb, claves[i], claves[i]);
+
+    // Consultas repetidas a la misma clave salen de la cache
+    bool ok = true;
+    for (size_t i = 0; i < 100 && ok; i++)
+        ok = abb_obtener(abb, claves[i % 2]) == claves[i % 2];
+    print_test("Prueba abb cache obtener claves frecuentes", ok);
+
+    print_test("Prueba abb cache reemplazar dato", abb_guardar(abb, "gato", claves[0]) && abb_obtener(abb, "gato") == claves[0]);
+    print_test("Prueba abb cache borrar clave cacheada", abb_borrar(abb, "perro") == claves[0]);
+    print_test("Prueba abb cache la clave borrada no esta", !abb_obtener(abb, "perro") && !abb_pertenece(abb, "perro"));
+
+    // Al mover nodos a otro arbol la cache no debe quedar apuntandolos
+    abb_pertenece(abb, "vaca");
+    abb_t* mayores = abb_partir(abb, "pato");
+    print_test("Prueba abb cache partir", !abb_pertenece(abb, "vaca") && abb_pertenece(mayores, "vaca"));
+    abb_destruir(mayores);
+    print_test("Prueba abb cache despues de destruir el otro arbol", !abb_obtener(abb, "vaca") && abb_pertenece(abb, "gato"));
+
+    abb_cache_desactivar(abb);
+    print_test("Prueba abb desactivar cache", abb_obtener(abb, "gato") == claves[0]);
+    abb_destruir(abb);
+}
+
+static void prueba_abb_acotado()
+{
+    abb_t* abb = abb_crear_acotado(strcmp, free, 3, 0);
+    char *claves[] = {"perro", "gato", "vaca", "pato", "burro"};
+    bool ok = true;
+
+    for (size_t i = 0; i < 3 && ok; i++)
+        ok = abb_guardar(abb, claves[i], malloc(sizeof(int)));
+    print_test("Prueba abb acotado guardar hasta el maximo", ok && abb_cantidad(abb) == 3);
+
+    // Consultar "perro" lo vuelve reciente, asi que se desaloja "gato"
+    print_test("Prueba abb acotado obtener", abb_obtener(abb, "perro"));
+    print_test("Prueba abb acotado guardar por encima del maximo", abb_guardar(abb, claves[3], malloc(sizeof(int))));
+    print_test("Prueba abb acotado la cantidad sigue en el maximo", abb_cantidad(abb) == 3);
+    print_test("Prueba abb acotado desaloja la menos usada", !abb_pertenece(abb, "gato"));
+    print_test("Prueba abb acotado conserva las usadas", abb_pertenece(abb, "perro") && abb_pertenece(abb, "vaca") && abb_pertenece(abb, "pato"));
+
+    // Reemplazar tambien cuenta como uso
+    abb_guardar(abb, "vaca", malloc(sizeof(int)));
+    abb_guardar(abb, claves[4], malloc(sizeof(int)));
+    print_test("Prueba abb acotado reemplazar vuelve reciente", !abb_pertenece(abb, "perro") && abb_pertenece(abb, "vaca"));
+
+    print_test("Prueba abb acotado no se puede partir", !abb_partir(abb, "gato"));
+    abb_t* otro = abb_crear(strcmp, free);
+    print_test("Prueba abb acotado no se puede unir", !abb_unir(abb, otro) && !abb_unir(otro, abb));
+    abb_destruir(otro);
+    abb_destruir(abb);
+
+    // Acotado por memoria: la memoria crece con el largo de las claves
+    abb = abb_crear(strcmp, NULL);
+    size_t vacio = abb_memoria(abb);
+    abb_guardar(abb, "a", NULL);
+    size_t nodo = abb_memoria(abb) - vacio;
+    abb_guardar(abb, "bbbbbbbbbb", NULL);
+    print_test("Prueba abb memoria cuenta las claves", abb_memoria(abb) - vacio == 2 * nodo + 9);
+    abb_guardar(abb, "a", NULL);
+    print_test("Prueba abb memoria reemplazar no cambia", abb_memoria(abb) - vacio == 2 * nodo + 9);
+    abb_borrar(abb, "bbbbbbbbbb");
+    print_test("Prueba abb memoria borrar descuenta", abb_memoria(abb) - vacio == nodo);
+    abb_destruir(abb);
+
+    // Solo los abbs acotados pagan la lista de uso y el vencimiento
+    abb = abb_crear_acotado(strcmp, NULL, 0, 0);
+    abb_guardar(abb, "a", NULL);
+    size_t nodo_acotado = abb_memoria(abb);
+    print_test("Prueba abb sin acotar usa nodos mas chicos", nodo < nodo_acotado);
+    abb_destruir(abb);
+
+    abb = abb_crear_acotado(strcmp, NULL, 0, 3 * nodo_acotado);
+    ok = true;
+    for (size_t i = 0; i < 5 && ok; i++)
+        ok = abb_guardar(abb, claves[i], NULL) && abb_memoria(abb) <= 3 * nodo_acotado;
+    print_test("Prueba abb acotado por memoria no supera el maximo", ok && abb_cantidad(abb) < 5);
+    print_test("Prueba abb acotado por memoria conserva la ultima", abb_pertenece(abb, "burro"));
+    abb_destruir(abb);
+
+    // Un lote mas grande que el maximo: los nodos desalojados se liberan de
+    // a uno, y la memoria es la de los que quedan
+    abb = abb_crear_acotado(strcmp, NULL, 100, 0);
+    const char* lote[1000];
+    void* datos_lote[1000];
+    char cadenas[1000][24];
+    for (size_t i = 0; i < 1000; i++) {
+        sprintf(cadenas[i], "%08zu", i);
+        lote[i] = cadenas[i];
+        datos_lote[i] = NULL;
+    }
+    print_test("Prueba abb acotado guardar lote", abb_guardar_lote(abb, lote, datos_lote, 1000, NULL) == 1000);
+    print_test("Prueba abb acotado lote queda en el maximo", abb_cantidad(abb) == 100 && abb_pertenece(abb, lote[999]));
+    print_test("Prueba abb acotado lote memoria de los que quedan", abb_memoria(abb) == 100 * (nodo_acotado + 7));
+    while (abb_compactar(abb, 30));
+    print_test("Prueba abb acotado compactar conserva la memoria", abb_cantidad(abb) == 100 && abb_memoria(abb) == 100 * (nodo_acotado + 7));
+    abb_destruir(abb);
+
+    // Vencimientos
+    abb = abb_crear(strcmp, free);
+    time_t ahora = time(NULL);
+    print_test("Prueba abb sin acotar no guarda vencimientos", !abb_guardar_con_vencimiento(abb, "perro", NULL, ahora + 3600) && !abb_cantidad(abb));
+    abb_destruir(abb);
+
+    abb = abb_crear_acotado(strcmp, free, 0, 0);
+    print_test("Prueba abb guardar vencida", abb_guardar_con_vencimiento(abb, "perro", malloc(sizeof(int)), ahora - 1));
+    print_test("Prueba abb guardar sin vencer", abb_guardar_con_vencimiento(abb, "gato", malloc(sizeof(int)), ahora + 3600));
+    abb_guardar(abb, "vaca", malloc(sizeof(int)));
+    abb_guardar_con_vencimiento(abb, "pato", malloc(sizeof(int)), ahora - 1);
+    print_test("Prueba abb la clave vencida no pertenece", !abb_pertenece(abb, "perro") && !abb_obtener(abb, "perro"));
+    print_test("Prueba abb la clave sin vencer pertenece", abb_pertenece(abb, "gato") && abb_pertenece(abb, "vaca"));
+    print_test("Prueba abb borrar clave vencida es NULL", !abb_borrar(abb, "perro"));
+    print_test("Prueba abb purgar vencidos", abb_purgar_vencidos(abb) == 1 && abb_cantidad(abb) == 2);
+    print_test("Prueba abb purgar sin vencidos", abb_purgar_vencidos(abb) == 0);
+
+    abb_guardar_con_vencimiento(abb, "pato", malloc(sizeof(int)), ahora - 1);
+    const char* vencidas[] = {"pato", "vaca"};
+    void* datos_vencidas[2];
+    print_test("Prueba abb borrar lote no cuenta la vencida", abb_borrar_lote(abb, vencidas, 2, datos_vencidas) == 1);
+    print_test("Prueba abb borrar lote da NULL para la vencida", !datos_vencidas[0] && datos_vencidas[1]);
+    print_test("Prueba abb borrar lote saca la vencida", abb_cantidad(abb) == 1 && !abb_pertenece(abb, "pato"));
+    free(datos_vencidas[1]);
+    abb_destruir(abb);
+
+    abb = abb_crear_acotado(strcmp, free, 0, 0);
+    abb_guardar_con_vencimiento(abb, "perro", malloc(sizeof(int)), ahora - 1);
+    abb_guardar_con_vencimiento(abb, "gato", malloc(sizeof(int)), ahora + 3600);
+    abb_guardar(abb, "vaca", malloc(sizeof(int)));
+    abb_congelado_t* congelado = abb_congelar(abb);
+    print_test("Prueba abb congelar saltea las vencidas", congelado && abb_congelado_cantidad(congelado) == 2 && !abb_congelado_pertenece(congelado, "perro"));
+    print_test("Prueba abb congelar conserva las vigentes", abb_congelado_pertenece(congelado, "gato") && abb_congelado_pertenece(congelado, "vaca"));
+    abb_congelado_destruir(congelado);
+}
+
+static bool contar_en_orden(const char* clave, void* dato, void* extra)
+{
+    char** anterior = extra;
+    if (*anterior && strcmp(*anterior, clave) >= 0)
+        return false;
+    *anterior = (char*) clave;
+    return true;
+}
+
+typedef struct escritor {
+    abb_particionado_t* particionado;
+    size_t desde;
+    size_t cantidad;
+    bool ok;
+} escritor_t;
+
+static void* escribir_claves(void* extra)
+{
+    escritor_t* escritor = extra;
+    char clave[24];
+    escritor->ok = true;
+    for (size_t i = escritor->desde; i < escritor->desde + escritor->cantidad && escritor->ok; i++) {
+        sprintf(clave, "%08zu", i);
+        escritor->ok = abb_particionado_guardar(escritor->particionado, clave, NULL)
+                    && abb_particionado_pertenece(escritor->particionado, clave);
+    }
+    return NULL;
+}
+
+static void prueba_abb_particionado(size_t largo)
+{
+    const char* limites[] = {"g", "p"};
+    abb_particionado_t* particionado = abb_particionado_crear(strcmp, NULL, limites, 2);
+    char *claves[] = {"perro", "gato", "vaca", "burro", "pato", "a"};
+
+    print_test("Prueba abb particionado crear", particionado && abb_particionado_particiones(particionado) == 3);
+    bool ok = true;
+    for (size_t i = 0; i < 6 && ok; i++)
+        ok = abb_particionado_guardar(particionado, claves[i], claves[i]);
+    print_test("Prueba abb particionado guardar", ok && abb_particionado_cantidad(particionado) == 6);
+    for (size_t i = 0; i < 6 && ok; i++)
+        ok = abb_particionado_obtener(particionado, claves[i]) == claves[i];
+    print_test("Prueba abb particionado obtener", ok);
+
+    char* anterior = NULL;
+    abb_particionado_in_order(particionado, contar_en_orden, &anterior);
+    print_test("Prueba abb particionado in order recorre en orden", anterior && !strcmp(anterior, "vaca"));
+
+    print_test("Prueba abb particionado borrar", abb_particionado_borrar(particionado, "gato") == claves[1]);
+    print_test("Prueba abb particionado la clave borrada no esta", !abb_particionado_pertenece(particionado, "gato") && abb_particionado_cantidad(particionado) == 5);
+    print_test("Prueba abb particionado rebalancear sin desbalance", abb_particionado_rebalancear(particionado) == 0);
+    abb_particionado_destruir(particionado);
+
+    // Varios hilos escriben a la vez; como todas las claves caen en la
+    // primera particion se rebalancea mientras escriben
+    particionado = abb_particionado_crear(strcmp, NULL, limites, 2);
+    escritor_t escritores[4];
+    pthread_t hilos[4];
+    for (size_t i = 0; i < 4; i++) {
+        escritores[i].particionado = particionado;
+        escritores[i].desde = i * largo;
+        escritores[i].cantidad = largo;
+        pthread_create(&hilos[i], NULL, escribir_claves, &escritores[i]);
+    }
+    ok = true;
+    for (size_t i = 0; i < 4; i++) {
+        pthread_join(hilos[i], NULL);
+        ok &= escritores[i].ok;
+    }
+    print_test("Prueba abb particionado guardar con varios hilos", ok);
+    print_test("Prueba abb particionado cantidad con varios hilos", abb_particionado_cantidad(particionado) == 4 * largo);
+
+    anterior = NULL;
+    abb_particionado_in_order(particionado, contar_en_orden, &anterior);
+    char ultima[24];
+    sprintf(ultima, "%08zu", 4 * largo - 1);
+    print_test("Prueba abb particionado in order despues de rebalancear", anterior && !strcmp(anterior, ultima));
+    abb_particionado_destruir(particionado);
+
+    // Con dos particiones y todas las claves menores al limite, la segunda
+    // particion solo recibe claves si el rebalanceo las mueve
+    const char* limite[] = {"m"};
+    particionado = abb_particionado_crear(strcmp, NULL, limite, 1);
+    ok = true;
+    for (size_t i = 0; i < 4 * largo && ok; i++) {
+        char clave[24];
+        sprintf(clave, "%08zu", i);
+        ok = abb_particionado_guardar(particionado, clave, NULL);
+    }
+    print_test("Prueba abb particionado dos particiones guardar", ok && abb_particionado_cantidad(particionado) == 4 * largo);
+    print_test("Prueba abb particionado dos particiones mueve claves", abb_particionado_cantidad_particion(particionado, 1) > 0);
+    print_test("Prueba abb particionado dos particiones sin desbalance", abb_particionado_rebalancear(particionado) == 0);
+    abb_particionado_destruir(particionado);
+}
+
+static void prueba_abb_borrar_rango(size_t largo)
+{
+    abb_t* abb = crear_abb_con_claves("mfthcpwbkr", free);
+
+    print_test("Prueba abb borrar rango vacio", abb_borrar_rango(abb, "n", "o") == 0 && abb_tiene_claves(abb, "bcfhkmprtw"));
+    print_test("Prueba abb borrar rango invertido", abb_borrar_rango(abb, "t", "c") == 0 && abb_cantidad(abb) == 10);
+    print_test("Prueba abb borrar rango incluye desde y excluye hasta", abb_borrar_rango(abb, "f", "p") == 4);
+    print_test("Prueba abb borrar rango quedan las de afuera", abb_tiene_claves(abb, "bcprtw"));
+    print_test("Prueba abb borrar rango hasta el final", abb_borrar_rango(abb, "s", "z") == 2 && abb_tiene_claves(abb, "bcpr"));
+    print_test("Prueba abb borrar rango todo", abb_borrar_rango(abb, "a", "z") == 4 && abb_cantidad(abb) == 0);
+    print_test("Prueba abb guardar despues de borrar rango", abb_guardar(abb, "g", malloc(sizeof(int))) && abb_tiene_claves(abb, "g"));
+    abb_destruir(abb);
+
+    // Claves guardadas en orden: el arbol degenerado no debe agotar la pila
+    abb = abb_crear(strcmp, NULL);
+    abb_filtro_activar(abb, largo, 0.01);
+    char clave[24], desde[24], hasta[24];
+    for (size_t i = 0; i < largo; i++) {
+        sprintf(clave, "%08zu", i);
+        abb_guardar(abb, clave, NULL);
+    }
+    sprintf(desde, "%08zu", largo / 4);
+    sprintf(hasta, "%08zu", 3 * largo / 4);
+    print_test("Prueba abb borrar rango volumen", abb_borrar_rango(abb, desde, hasta) == largo / 2 && abb_cantidad(abb) == largo / 2);
+    bool ok = true;
+    for (size_t i = 0; i < largo && ok; i++) {
+        sprintf(clave, "%08zu", i);
+        ok = abb_pertenece(abb, clave) == (i < largo / 4 || i >= 3 * largo / 4);
+    }
+    print_test("Prueba abb borrar rango volumen pertenencia", ok);
+    abb_destruir(abb);
+
+    // Mas profundo de lo que aguantaria una recursion, tambien al destruir
+    abb = crear_abb_degenerado(LARGO_DEGENERADO, 0, 1);
+    print_test("Prueba abb borrar rango en abb degenerado", abb_borrar_rango(abb, "00000010", "00000020") == 10 && abb_cantidad(abb) == LARGO_DEGENERADO - 10);
+    abb_destruir(abb);
+}
+
+static void prueba_abb_cursor(size_t largo)
+{
+    abb_t* abb = crear_abb_con_claves("mfthcpwbkr", NULL);
+    abb_cursor_t* cursor = abb_cursor_crear(abb);
+
+    print_test("Prueba abb cursor crear", cursor);
+    print_test("Prueba abb cursor pertenece", abb_cursor_pertenece(cursor, "c") && abb_cursor_pertenece(cursor, "k"));
+    print_test("Prueba abb cursor clave ausente", !abb_cursor_pertenece(cursor, "d") && !abb_cursor_obtener(cursor, "z"));
+    print_test("Prueba abb cursor guardar", abb_cursor_guardar(cursor, "d", &largo) && abb_cursor_obtener(cursor, "d") == &largo);
+    print_test("Prueba abb cursor guardar queda en el abb", abb_obtener(abb, "d") == &largo && abb_tiene_claves(abb, "bcdfhkmprtw"));
+
+    // Despues de borrar la clave del dedo el cursor vuelve a la raiz
+    print_test("Prueba abb cursor borrar la clave del dedo", abb_borrar(abb, "d") == &largo);
+    print_test("Prueba abb cursor despues de borrar", !abb_cursor_pertenece(cursor, "d") && abb_cursor_pertenece(cursor, "w"));
+    abb_t* mayores = abb_partir(abb, "p");
+    print_test("Prueba abb cursor despues de partir", !abb_cursor_pertenece(cursor, "w") && abb_cursor_pertenece(cursor, "m"));
+    abb_destruir(mayores);
+    abb_cursor_destruir(cursor);
+    abb_destruir(abb);
+
+    // Claves guardadas y consultadas en orden
+    abb = abb_crear(strcmp, NULL);
+    cursor = abb_cursor_crear(abb);
+    char clave[24];
+    bool ok = true;
+    for (size_t i = 0; i < largo && ok; i++) {
+        sprintf(clave, "%08zu", (i * 7) % largo);
+        ok = abb_cursor_guardar(cursor, clave, NULL);
+    }
+    print_test("Prueba abb cursor guardar volumen", ok && abb_cantidad(abb) == largo);
+    for (size_t i = 0; i < largo && ok; i++) {
+        sprintf(clave, "%08zu", i);
+        ok = abb_cursor_pertenece(cursor, clave);
+        sprintf(clave, "%08zu_", i);
+        ok = ok && !abb_cursor_pertenece(cursor, clave);
+    }
+    print_test("Prueba abb cursor buscar volumen en orden", ok);
+    abb_cursor_destruir(cursor);
+    abb_destruir(abb);
+}
+
+static void prueba_abb_compactar(size_t largo)
+{
+    abb_t* abb = abb_crear(strcmp, NULL);
+    print_test("Prueba abb compactar abb vacio", !abb_compactar(abb, 10) && !abb_compactar(abb, 0));
+    abb_destruir(abb);
+
+    // Un abb acotado con cache y filtro, para que se reubiquen todos los
+    // punteros a los nodos
+    abb = abb_crear_acotado(strcmp, NULL, largo, 0);
+    abb_cache_activar(abb, 64);
+    abb_filtro_activar(abb, largo, 0.01);
+    char clave[24];
+    for (size_t i = 0; i < largo; i++) {
+        sprintf(clave, "%08zu", (i * 7) % largo);
+        abb_guardar(abb, clave, NULL);
+        if (i % 3 == 0)
+            abb_borrar(abb, clave);
+    }
+    size_t cantidad = abb_cantidad(abb);
+    size_t memoria = abb_memoria(abb);
+    abb_cursor_t* cursor = abb_cursor_crear(abb);
+    abb_cursor_pertenece(cursor, "00000001");
+
+    size_t tramos = 0;
+    while (abb_compactar(abb, largo / 10)) {
+        tramos++;
+        // Entre tramos el abb se sigue usando
+        sprintf(clave, "%08zu_", tramos);
+        abb_guardar(abb, clave, NULL);
+        abb_borrar(abb, clave);
+    }
+    print_test("Prueba abb compactar de a tramos", tramos >= 5 && tramos <= 10);
+    print_test("Prueba abb compactar conserva cantidad y memoria", abb_cantidad(abb) == cantidad && abb_memoria(abb) == memoria);
+
+    bool ok = true;
+    for (size_t i = 0; i < largo && ok; i++) {
+        sprintf(clave, "%08zu", (i * 7) % largo);
+        ok = abb_pertenece(abb, clave) == (i % 3 != 0) && abb_cursor_pertenece(cursor, clave) == (i % 3 != 0);
+    }
+    print_test("Prueba abb compactar conserva las claves", ok);
+
+    char* anterior = NULL;
+    size_t recorridos = 0;
+    abb_iter_t* iter = abb_iter_in_crear(abb);
+    for (; !abb_iter_in_al_final(iter) && ok; abb_iter_in_avanzar(iter), recorridos++) {
+        ok = !anterior || strcmp(anterior, abb_iter_in_ver_actual(iter)) < 0;
+        anterior = (char*) abb_iter_in_ver_actual(iter);
+    }
+    abb_iter_in_destruir(iter);
+    print_test("Prueba abb compactar conserva el orden", ok && recorridos == cantidad);
+
+    // El desalojo sigue la lista de uso a traves de los nodos movidos
+    for (size_t i = 0; i < largo && ok; i++) {
+        sprintf(clave, "x%08zu", i);
+        ok = abb_guardar(abb, clave, NULL);
+    }
+    print_test("Prueba abb compactar y despues desalojar", ok && abb_cantidad(abb) == largo && !abb_pertenece(abb, "00000001"));
+    print_test("Prueba abb compactar todo de una vez", !abb_compactar(abb, 0) && abb_cantidad(abb) == largo);
+
+    abb_cursor_destruir(cursor);
+    abb_destruir(abb);
+}
+
+static void prueba_abb_recorrer_y_modificar()
+{
+    abb_t* abb = crear_abb_con_claves("mfthcpwbkr", free);
+
+    // Cada llamada sigue donde corto la anterior: 3 + 3 + 3 + 1
+    abb_iter_t* iter = abb_iter_in_crear(abb);
+    size_t contador = 0;
+    abb_iter_in_recorrer(iter, contar_hasta_tres, &contador);
+    print_test("Prueba abb iter recorrer se pausa", contador == 3 && !strcmp(abb_iter_in_ver_actual(iter), "h"));
+    contador = 0;
+    abb_iter_in_recorrer(iter, contar_hasta_tres, &contador);
+    contador = 0;
+    abb_iter_in_recorrer(iter, contar_hasta_tres, &contador);
+    print_test("Prueba abb iter recorrer continua", contador == 3 && !strcmp(abb_iter_in_ver_actual(iter), "w"));
+    contador = 0;
+    abb_iter_in_recorrer(iter, contar_hasta_tres, &contador);
+    print_test("Prueba abb iter recorrer llega al final", contador == 1 && abb_iter_in_al_final(iter));
+    contador = 0;
+    abb_iter_in_recorrer(iter, contar_hasta_tres, &contador);
+    print_test("Prueba abb iter recorrer al final no visita", contador == 0);
+    abb_iter_in_destruir(iter);
+
+    // Una sola pasada que borra unas claves y reemplaza el dato de otra,
+    // con un segundo iterador parado en una clave que no se borra
+    iter = abb_iter_in_crear(abb);
+    abb_iter_t* otro = abb_iter_in_crear(abb);
+    for (size_t i = 0; i < 3; i++)
+        abb_iter_in_avanzar(otro);
+    int* nuevo = malloc(sizeof(int));
+    *nuevo = 42;
+    bool ok = true;
+    while (!abb_iter_in_al_final(iter) && ok) {
+        const char* clave = abb_iter_in_ver_actual(iter);
+        if (strchr("cfkp", clave[0]))
+            free(abb_iter_in_borrar_actual(abb, iter));
+        else if (clave[0] == 'r')
+            ok = abb_iter_in_reemplazar_dato(abb, iter, nuevo) && abb_iter_in_avanzar(iter);
+        else
+            abb_iter_in_avanzar(iter);
+    }
+    print_test("Prueba abb iter borrar actual en una pasada", ok && abb_tiene_claves(abb, "bhmrtw"));
+    print_test("Prueba abb iter reemplazar dato", abb_obtener(abb, "r") == nuevo);
+    print_test("Prueba abb iter borrar al final es NULL", !abb_iter_in_borrar_actual(abb, iter) && !abb_iter_in_ver_dato(iter));
+    print_test("Prueba abb otro iterador sigue valido", !strcmp(abb_iter_in_ver_actual(otro), "h") && abb_iter_in_ver_dato(otro));
+    abb_iter_in_destruir(otro);
+    abb_iter_in_destruir(iter);
+
+    // Un iterador de otro abb no lo modifica
+    abb_t* vacio = abb_crear(strcmp, free);
+    iter = abb_iter_in_crear(abb);
+    print_test("Prueba abb iter borrar con otro abb es NULL", !abb_iter_in_borrar_actual(vacio, iter) && abb_cantidad(abb) == 6);
+    abb_iter_in_destruir(iter);
+    abb_destruir(vacio);
+    abb_destruir(abb);
+}
+
+static void prueba_abb_exportar_importar(size_t largo)
+{
+    abb_t* abb = crear_abb_con_claves("mfthcpwbkr", NULL);
+    const char* claves[10];
+    size_t largos[10];
+    void* datos[10];
+
+    print_test("Prueba abb exportar todo", abb_exportar(abb, NULL, NULL, claves, largos, datos, 10) == 10);
+    bool ok = true;
+    for (size_t i = 1; i < 10 && ok; i++)
+        ok = strcmp(claves[i - 1], claves[i]) < 0 && largos[i] == 1 && datos[i] == abb_obtener(abb, claves[i]);
+    print_test("Prueba abb exportar en orden", ok && !strcmp(claves[0], "b") && !strcmp(claves[9], "w"));
+    print_test("Prueba abb exportar hasta la capacidad", abb_exportar(abb, NULL, NULL, claves, NULL, NULL, 4) == 4 && !strcmp(claves[3], "h"));
+    print_test("Prueba abb exportar rango", abb_exportar(abb, "g", "p", claves, NULL, NULL, 10) == 3 && !strcmp(claves[0], "h") && !strcmp(claves[2], "m"));
+    print_test("Prueba abb exportar rango vacio", abb_exportar(abb, "x", NULL, claves, NULL, NULL, 10) == 0);
+
+    abb_exportacion_t* exportacion = abb_exportar_rango(abb, "f", NULL);
+    print_test("Prueba abb exportar rango nuevo", exportacion && exportacion->cantidad == 8 && !strcmp(exportacion->claves[0], "f"));
+    abb_t* copia = abb_crear(strcmp, NULL);
+    print_test("Prueba abb importar", abb_importar(copia, exportacion) == 8 && abb_tiene_claves(copia, "fhkmprtw"));
+    abb_exportacion_destruir(exportacion);
+    abb_destruir(copia);
+    abb_destruir(abb);
+
+    // Ida y vuelta en volumen
+    abb = abb_crear(strcmp, NULL);
+    char clave[24];
+    for (size_t i = 0; i < largo; i++) {
+        sprintf(clave, "%08zu", (i * 7) % largo);
+        abb_guardar(abb, clave, NULL);
+    }
+    exportacion = abb_exportar_rango(abb, NULL, NULL);
+    copia = abb_crear(strcmp, NULL);
+    print_test("Prueba abb exportar volumen", exportacion && exportacion->cantidad == largo && exportacion->largos[largo - 1] == 8);
+    print_test("Prueba abb importar volumen", abb_importar(copia, exportacion) == largo && abb_cantidad(copia) == largo);
+    ok = true;
+    for (size_t i = 0; i < largo && ok; i++) {
+        sprintf(clave, "%08zu", i);
+        ok = abb_pertenece(copia, clave) && !strcmp(exportacion->claves[i], clave);
+    }
+    print_test("Prueba abb importar volumen pertenencia", ok);
+    abb_exportacion_destruir(exportacion);
+    abb_destruir(copia);
+    abb_destruir(abb);
+}
+
 /* ******************************************************************
  *                        FUNCIÓN PRINCIPAL
  * *****************************************************************/
@@ -450,4 +1430,20 @@ void pruebas_abb_alumno() {
     prueba_abb_volumen(1000, true);
     prueba_abb_iterar();
     prueba_abb_iterar_volumen(1000);
+    prueba_abb_iterar_con_cambios();
+    prueba_abb_iterar_reverso();
+    prueba_abb_conjuntos();
+    prueba_abb_generico(1000);
+    prueba_abb_entero();
+    prueba_abb_congelar(1000);
+    prueba_abb_lote(1000);
+    prueba_abb_filtro(1000);
+    prueba_abb_cache();
+    prueba_abb_acotado();
+    prueba_abb_particionado(1000);
+    prueba_abb_borrar_rango(1000);
+    prueba_abb_cursor(1000);
+    prueba_abb_compactar(1000);
+    prueba_abb_recorrer_y_modificar();
+    prueba_abb_exportar_importar(1000);
 }